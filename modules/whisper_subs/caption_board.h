@@ -0,0 +1,150 @@
+#ifndef WHISPER_SUBS_CAPTION_BOARD_H
+#define WHISPER_SUBS_CAPTION_BOARD_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <mutex>
+
+// Subtítulos publicados por los workers de inferencia para el sub source.
+// Hay un tablero por reproductor (ver caption_board_acquire), así que cada
+// vídeo solo muestra los subtítulos de su propio audio.
+//
+// Es un seqlock: los workers se serializan entre sí con writer_lock, pero el
+// hilo de vídeo nunca toma un mutex; copia el tablero y reintenta si la copia
+// se solapó con una escritura. Las escrituras son pocas por segundo, así que
+// en la práctica el lector casi nunca reintenta, y si no lo consigue en
+// CAPTION_READ_RETRIES se queda con la copia anterior hasta el próximo frame.
+
+static const size_t CAPTION_TEXT_MAX = 512;
+static const unsigned CAPTION_SLOTS = 8;
+static const unsigned CAPTION_READ_RETRIES = 64;
+
+struct caption_t {
+    uint64_t id;        // 0 = vacío; crece con cada publicación
+    int64_t start;      // mtime_t
+    int64_t stop;
+    bool partial;       // hipótesis inestable, la reemplaza la siguiente
+    char text[CAPTION_TEXT_MAX];
+};
+
+struct caption_snapshot_t {
+    uint32_t seq;
+    uint64_t last_id;
+    caption_t slots[CAPTION_SLOTS];
+};
+
+class CaptionBoard {
+public:
+    // Workers: publica un subtítulo y devuelve su id
+    uint64_t publish(const char *text, int64_t start, int64_t stop, bool partial)
+    {
+        std::lock_guard<std::mutex> lock(writer_lock_);
+
+        const uint32_t seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        const uint64_t id = last_id_ + 1;
+        caption_t &c = slots_[id % CAPTION_SLOTS];
+        c.id = id;
+        c.start = start;
+        c.stop = stop;
+        c.partial = partial;
+        copy_utf8(c.text, text);
+        last_id_ = id;
+
+        seq_.store(seq + 2, std::memory_order_release);
+        return id;
+    }
+
+    // Generación actual; cambia con cada publicación
+    uint32_t generation() const { return seq_.load(std::memory_order_acquire); }
+
+    // Lector (hilo de vídeo): copia coherente del tablero, sin bloquear. Si
+    // todos los intentos se solapan con escrituras devuelve false y deja
+    // snap como estaba.
+    bool read(caption_snapshot_t *snap) const
+    {
+        caption_snapshot_t copy;
+        for (unsigned i = 0; i < CAPTION_READ_RETRIES; ++i) {
+            const uint32_t seq = seq_.load(std::memory_order_acquire);
+            if (seq & 1) continue; // escritura en curso
+            memcpy(copy.slots, slots_, sizeof(slots_));
+            copy.last_id = last_id_;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load(std::memory_order_relaxed) == seq) {
+                copy.seq = seq;
+                *snap = copy;
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    // Copia truncando sin partir un carácter UTF-8
+    static void copy_utf8(char *dst, const char *src)
+    {
+        size_t n = strlen(src);
+        if (n >= CAPTION_TEXT_MAX) {
+            n = CAPTION_TEXT_MAX - 1;
+            while (n > 0 && ((unsigned char)src[n] & 0xC0) == 0x80)
+                n--;
+        }
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+
+    std::mutex writer_lock_;
+    std::atomic<uint32_t> seq_{0};
+    uint64_t last_id_ = 0;
+    caption_t slots_[CAPTION_SLOTS] = {};
+};
+
+// Tableros por dueño: el filtro de audio y el sub source de un mismo
+// reproductor piden el suyo con el mismo dueño y lo comparten; se libera
+// cuando lo sueltan los dos.
+struct caption_board_entry_t {
+    CaptionBoard *board;
+    unsigned refs;
+};
+
+static inline std::mutex &caption_board_lock()
+{
+    static std::mutex lock;
+    return lock;
+}
+
+static inline std::map<const void *, caption_board_entry_t> &caption_board_map()
+{
+    static std::map<const void *, caption_board_entry_t> boards;
+    return boards;
+}
+
+static inline CaptionBoard *caption_board_acquire(const void *owner)
+{
+    std::lock_guard<std::mutex> guard(caption_board_lock());
+    caption_board_entry_t &e = caption_board_map()[owner];
+    if (!e.board)
+        e.board = new CaptionBoard();
+    e.refs++;
+    return e.board;
+}
+
+static inline void caption_board_release(CaptionBoard *board)
+{
+    std::lock_guard<std::mutex> guard(caption_board_lock());
+    auto &boards = caption_board_map();
+    for (auto it = boards.begin(); it != boards.end(); ++it) {
+        if (it->second.board != board) continue;
+        if (--it->second.refs == 0) {
+            delete board;
+            boards.erase(it);
+        }
+        return;
+    }
+}
+
+#endif
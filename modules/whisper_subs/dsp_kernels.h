@@ -0,0 +1,447 @@
+#ifndef WHISPER_SUBS_DSP_KERNELS_H
+#define WHISPER_SUBS_DSP_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+# include <immintrin.h>
+# define WSUBS_HAVE_SSE 1
+# if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define WSUBS_HAVE_SSE2 1
+# endif
+# if defined(__GNUC__) || defined(__clang__)
+   // AVX2 se compila siempre y se elige en tiempo de ejecución
+#  define WSUBS_HAVE_AVX2 1
+#  define WSUBS_TARGET_AVX2 __attribute__((target("avx2,fma")))
+# elif defined(__AVX2__)
+#  define WSUBS_HAVE_AVX2 1
+#  define WSUBS_TARGET_AVX2
+# endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+# include <arm_neon.h>
+# define WSUBS_HAVE_NEON 1
+#endif
+
+// Kernels DSP del plugin. Cada kernel tiene variante escalar y SIMD para
+// poder compararlas; dsp_*() elige la mejor disponible en esta CPU.
+
+static inline float dot_scalar(const float *a, const float *b, size_t n)
+{
+    float acc = 0.0f;
+    for (size_t i = 0; i < n; ++i)
+        acc += a[i] * b[i];
+    return acc;
+}
+
+#ifdef WSUBS_HAVE_SSE
+// n debe ser múltiplo de 4
+static inline float dot_sse(const float *a, const float *b, size_t n)
+{
+    __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    for (; i < n; i += 4)
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    acc0 = _mm_add_ps(acc0, acc1);
+    acc0 = _mm_add_ps(acc0, _mm_movehl_ps(acc0, acc0));
+    acc0 = _mm_add_ss(acc0, _mm_shuffle_ps(acc0, acc0, 1));
+    return _mm_cvtss_f32(acc0);
+}
+#endif
+
+#ifdef WSUBS_HAVE_AVX2
+// n debe ser múltiplo de 8
+WSUBS_TARGET_AVX2
+static inline float dot_avx2(const float *a, const float *b, size_t n)
+{
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+    }
+    for (; i < n; i += 8)
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+    acc0 = _mm256_add_ps(acc0, acc1);
+    __m128 lo = _mm_add_ps(_mm256_castps256_ps128(acc0), _mm256_extractf128_ps(acc0, 1));
+    lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+    lo = _mm_add_ss(lo, _mm_shuffle_ps(lo, lo, 1));
+    return _mm_cvtss_f32(lo);
+}
+
+static inline bool cpu_has_avx2()
+{
+# if defined(__GNUC__) || defined(__clang__)
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+# else
+    return true; // compilado con /arch:AVX2
+# endif
+}
+#endif
+
+#ifdef WSUBS_HAVE_NEON
+// n debe ser múltiplo de 4
+static inline float dot_neon(const float *a, const float *b, size_t n)
+{
+    float32x4_t acc0 = vdupq_n_f32(0.0f), acc1 = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    for (; i < n; i += 4)
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+    acc0 = vaddq_f32(acc0, acc1);
+    float32x2_t s = vadd_f32(vget_low_f32(acc0), vget_high_f32(acc0));
+    return vget_lane_f32(vpadd_f32(s, s), 0);
+}
+#endif
+
+typedef float (*dot_fn)(const float *, const float *, size_t);
+
+// Producto escalar para longitudes múltiplo de 8
+static inline dot_fn dsp_dot()
+{
+#if defined(WSUBS_HAVE_AVX2)
+    if (cpu_has_avx2()) return dot_avx2;
+#endif
+#if defined(WSUBS_HAVE_SSE)
+    return dot_sse;
+#elif defined(WSUBS_HAVE_NEON)
+    return dot_neon;
+#else
+    return dot_scalar;
+#endif
+}
+
+/* -------------------------------------------------------------------------
+ * Downmix: audio entrelazado de ch canales -> mono, out[i] = sum(in[i*ch+c] * w[c])
+ * ------------------------------------------------------------------------- */
+
+typedef void (*downmix_fn)(const float *in, float *out, size_t frames,
+                           const float *w, unsigned ch);
+
+static inline void downmix_scalar(const float *in, float *out, size_t frames,
+                                  const float *w, unsigned ch)
+{
+    for (size_t i = 0; i < frames; ++i) {
+        const float *f = in + i * ch;
+        float acc = 0.0f;
+        for (unsigned c = 0; c < ch; ++c)
+            acc += f[c] * w[c];
+        out[i] = acc;
+    }
+}
+
+// Variante escalar con ch fijo en compilación (el compilador desenrolla)
+template <unsigned N>
+static inline void downmix_scalar_n(const float *in, float *out, size_t frames,
+                                    const float *w, unsigned)
+{
+    for (size_t i = 0; i < frames; ++i) {
+        const float *f = in + i * N;
+        float acc = 0.0f;
+        for (unsigned c = 0; c < N; ++c)
+            acc += f[c] * w[c];
+        out[i] = acc;
+    }
+}
+
+#ifdef WSUBS_HAVE_SSE
+static inline void downmix_sse_1(const float *in, float *out, size_t frames,
+                                 const float *w, unsigned)
+{
+    const __m128 w0 = _mm_set1_ps(w[0]);
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4)
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(in + i), w0));
+    downmix_scalar_n<1>(in + i, out + i, frames - i, w, 1);
+}
+
+static inline void downmix_sse_2(const float *in, float *out, size_t frames,
+                                 const float *w, unsigned)
+{
+    const __m128 wl = _mm_set1_ps(w[0]), wr = _mm_set1_ps(w[1]);
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        const __m128 a = _mm_loadu_ps(in + 2 * i);      // L0 R0 L1 R1
+        const __m128 b = _mm_loadu_ps(in + 2 * i + 4);  // L2 R2 L3 R3
+        const __m128 l = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 r = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(l, wl), _mm_mul_ps(r, wr)));
+    }
+    downmix_scalar_n<2>(in + 2 * i, out + i, frames - i, w, 2);
+}
+
+// Suma horizontal de 4 vectores: devuelve [sum(r0) sum(r1) sum(r2) sum(r3)]
+static inline __m128 sse_hsum4(__m128 r0, __m128 r1, __m128 r2, __m128 r3)
+{
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    return _mm_add_ps(_mm_add_ps(r0, r1), _mm_add_ps(r2, r3));
+}
+
+// 5.1: dos tramas ocupan tres vectores [a0..a3] [a4 a5 b0 b1] [b2..b5]
+static inline void downmix_sse_6(const float *in, float *out, size_t frames,
+                                 const float *w, unsigned)
+{
+    const __m128 wa = _mm_loadu_ps(w);
+    const __m128 wm_a = _mm_setr_ps(w[4], w[5], 0.0f, 0.0f);
+    const __m128 wm_b = _mm_setr_ps(0.0f, 0.0f, w[0], w[1]);
+    const __m128 wb = _mm_setr_ps(w[2], w[3], w[4], w[5]);
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        const float *p = in + 6 * i;
+        __m128 r[4];
+        for (int k = 0; k < 2; ++k) {
+            const __m128 v0 = _mm_loadu_ps(p + 12 * k);
+            const __m128 v1 = _mm_loadu_ps(p + 12 * k + 4);
+            const __m128 v2 = _mm_loadu_ps(p + 12 * k + 8);
+            r[2 * k]     = _mm_add_ps(_mm_mul_ps(v0, wa), _mm_mul_ps(v1, wm_a));
+            r[2 * k + 1] = _mm_add_ps(_mm_mul_ps(v1, wm_b), _mm_mul_ps(v2, wb));
+        }
+        _mm_storeu_ps(out + i, sse_hsum4(r[0], r[1], r[2], r[3]));
+    }
+    downmix_scalar_n<6>(in + 6 * i, out + i, frames - i, w, 6);
+}
+
+// 7.1: cada trama son dos vectores
+static inline void downmix_sse_8(const float *in, float *out, size_t frames,
+                                 const float *w, unsigned)
+{
+    const __m128 w0 = _mm_loadu_ps(w), w1 = _mm_loadu_ps(w + 4);
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        const float *p = in + 8 * i;
+        __m128 r[4];
+        for (int k = 0; k < 4; ++k)
+            r[k] = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(p + 8 * k), w0),
+                              _mm_mul_ps(_mm_loadu_ps(p + 8 * k + 4), w1));
+        _mm_storeu_ps(out + i, sse_hsum4(r[0], r[1], r[2], r[3]));
+    }
+    downmix_scalar_n<8>(in + 8 * i, out + i, frames - i, w, 8);
+}
+#endif
+
+#ifdef WSUBS_HAVE_NEON
+static inline void downmix_neon_1(const float *in, float *out, size_t frames,
+                                  const float *w, unsigned)
+{
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4)
+        vst1q_f32(out + i, vmulq_n_f32(vld1q_f32(in + i), w[0]));
+    downmix_scalar_n<1>(in + i, out + i, frames - i, w, 1);
+}
+
+static inline void downmix_neon_2(const float *in, float *out, size_t frames,
+                                  const float *w, unsigned)
+{
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        const float32x4x2_t lr = vld2q_f32(in + 2 * i);
+        vst1q_f32(out + i, vmlaq_n_f32(vmulq_n_f32(lr.val[0], w[0]), lr.val[1], w[1]));
+    }
+    downmix_scalar_n<2>(in + 2 * i, out + i, frames - i, w, 2);
+}
+
+static inline float32x4_t neon_hsum4(float32x4_t r0, float32x4_t r1, float32x4_t r2, float32x4_t r3)
+{
+    return vpaddq_f32(vpaddq_f32(r0, r1), vpaddq_f32(r2, r3));
+}
+
+static inline void downmix_neon_6(const float *in, float *out, size_t frames,
+                                  const float *w, unsigned)
+{
+    const float wm_a_v[4] = { w[4], w[5], 0.0f, 0.0f };
+    const float wm_b_v[4] = { 0.0f, 0.0f, w[0], w[1] };
+    const float wb_v[4] = { w[2], w[3], w[4], w[5] };
+    const float32x4_t wa = vld1q_f32(w), wm_a = vld1q_f32(wm_a_v);
+    const float32x4_t wm_b = vld1q_f32(wm_b_v), wb = vld1q_f32(wb_v);
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        const float *p = in + 6 * i;
+        float32x4_t r[4];
+        for (int k = 0; k < 2; ++k) {
+            const float32x4_t v0 = vld1q_f32(p + 12 * k);
+            const float32x4_t v1 = vld1q_f32(p + 12 * k + 4);
+            const float32x4_t v2 = vld1q_f32(p + 12 * k + 8);
+            r[2 * k]     = vmlaq_f32(vmulq_f32(v0, wa), v1, wm_a);
+            r[2 * k + 1] = vmlaq_f32(vmulq_f32(v1, wm_b), v2, wb);
+        }
+        vst1q_f32(out + i, neon_hsum4(r[0], r[1], r[2], r[3]));
+    }
+    downmix_scalar_n<6>(in + 6 * i, out + i, frames - i, w, 6);
+}
+
+static inline void downmix_neon_8(const float *in, float *out, size_t frames,
+                                  const float *w, unsigned)
+{
+    const float32x4_t w0 = vld1q_f32(w), w1 = vld1q_f32(w + 4);
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        const float *p = in + 8 * i;
+        float32x4_t r[4];
+        for (int k = 0; k < 4; ++k)
+            r[k] = vmlaq_f32(vmulq_f32(vld1q_f32(p + 8 * k), w0), vld1q_f32(p + 8 * k + 4), w1);
+        vst1q_f32(out + i, neon_hsum4(r[0], r[1], r[2], r[3]));
+    }
+    downmix_scalar_n<8>(in + 8 * i, out + i, frames - i, w, 8);
+}
+#endif
+
+// Kernel de downmix para ch canales; simd = false fuerza la variante escalar
+static inline downmix_fn dsp_downmix(unsigned ch, bool simd = true)
+{
+    if (simd) {
+#if defined(WSUBS_HAVE_SSE)
+        switch (ch) {
+            case 1: return downmix_sse_1;
+            case 2: return downmix_sse_2;
+            case 6: return downmix_sse_6;
+            case 8: return downmix_sse_8;
+        }
+#elif defined(WSUBS_HAVE_NEON)
+        switch (ch) {
+            case 1: return downmix_neon_1;
+            case 2: return downmix_neon_2;
+            case 6: return downmix_neon_6;
+            case 8: return downmix_neon_8;
+        }
+#endif
+    }
+    switch (ch) {
+        case 1: return downmix_scalar_n<1>;
+        case 2: return downmix_scalar_n<2>;
+        case 6: return downmix_scalar_n<6>;
+        case 8: return downmix_scalar_n<8>;
+        default: return downmix_scalar;
+    }
+}
+
+/* -------------------------------------------------------------------------
+ * Conversión de formato a float sin escalar: el factor (1/32768, 1/2^31)
+ * se aplica en los pesos del downmix, así la conversión es un solo cvt.
+ * ------------------------------------------------------------------------- */
+
+typedef void (*convert_fn)(const void *in, float *out, size_t n);
+
+static inline void convert_s16_scalar(const void *in, float *out, size_t n)
+{
+    const int16_t *p = (const int16_t *)in;
+    for (size_t i = 0; i < n; ++i) out[i] = (float)p[i];
+}
+
+static inline void convert_s32_scalar(const void *in, float *out, size_t n)
+{
+    const int32_t *p = (const int32_t *)in;
+    for (size_t i = 0; i < n; ++i) out[i] = (float)p[i];
+}
+
+static inline void convert_f64_scalar(const void *in, float *out, size_t n)
+{
+    const double *p = (const double *)in;
+    for (size_t i = 0; i < n; ++i) out[i] = (float)p[i];
+}
+
+#ifdef WSUBS_HAVE_SSE2
+static inline void convert_s16_sse2(const void *in, float *out, size_t n)
+{
+    const int16_t *p = (const int16_t *)in;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        // Extensión de signo: el s16 queda en la mitad alta y se desplaza
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(out + i, _mm_cvtepi32_ps(lo));
+        _mm_storeu_ps(out + i + 4, _mm_cvtepi32_ps(hi));
+    }
+    convert_s16_scalar(p + i, out + i, n - i);
+}
+
+static inline void convert_s32_sse2(const void *in, float *out, size_t n)
+{
+    const int32_t *p = (const int32_t *)in;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm_storeu_ps(out + i, _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(p + i))));
+    convert_s32_scalar(p + i, out + i, n - i);
+}
+
+static inline void convert_f64_sse2(const void *in, float *out, size_t n)
+{
+    const double *p = (const double *)in;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(p + i));
+        const __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(p + i + 2));
+        _mm_storeu_ps(out + i, _mm_movelh_ps(lo, hi));
+    }
+    convert_f64_scalar(p + i, out + i, n - i);
+}
+#endif
+
+#ifdef WSUBS_HAVE_NEON
+static inline void convert_s16_neon(const void *in, float *out, size_t n)
+{
+    const int16_t *p = (const int16_t *)in;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const int16x8_t v = vld1q_s16(p + i);
+        vst1q_f32(out + i, vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))));
+        vst1q_f32(out + i + 4, vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))));
+    }
+    convert_s16_scalar(p + i, out + i, n - i);
+}
+
+static inline void convert_s32_neon(const void *in, float *out, size_t n)
+{
+    const int32_t *p = (const int32_t *)in;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        vst1q_f32(out + i, vcvtq_f32_s32(vld1q_s32(p + i)));
+    convert_s32_scalar(p + i, out + i, n - i);
+}
+
+static inline void convert_f64_neon(const void *in, float *out, size_t n)
+{
+    const double *p = (const double *)in;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        vst1q_f32(out + i, vcombine_f32(vcvt_f32_f64(vld1q_f64(p + i)),
+                                        vcvt_f32_f64(vld1q_f64(p + i + 2))));
+    convert_f64_scalar(p + i, out + i, n - i);
+}
+#endif
+
+enum sample_format_t { SAMPLE_S16, SAMPLE_S32, SAMPLE_F64 };
+
+// Kernel de conversión a float; simd = false fuerza la variante escalar
+static inline convert_fn dsp_convert(sample_format_t fmt, bool simd = true)
+{
+    if (simd) {
+#if defined(WSUBS_HAVE_SSE2)
+        switch (fmt) {
+            case SAMPLE_S16: return convert_s16_sse2;
+            case SAMPLE_S32: return convert_s32_sse2;
+            case SAMPLE_F64: return convert_f64_sse2;
+        }
+#elif defined(WSUBS_HAVE_NEON)
+        switch (fmt) {
+            case SAMPLE_S16: return convert_s16_neon;
+            case SAMPLE_S32: return convert_s32_neon;
+            case SAMPLE_F64: return convert_f64_neon;
+        }
+#endif
+    }
+    switch (fmt) {
+        case SAMPLE_S16: return convert_s16_scalar;
+        case SAMPLE_S32: return convert_s32_scalar;
+        default:         return convert_f64_scalar;
+    }
+}
+
+#endif
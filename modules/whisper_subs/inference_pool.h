@@ -0,0 +1,161 @@
+#ifndef WHISPER_SUBS_INFERENCE_POOL_H
+#define WHISPER_SUBS_INFERENCE_POOL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+# include <pthread.h>
+# include <sched.h>
+#endif
+
+#include "whisper.h"
+
+// Trabajo de inferencia: una ventana de audio decodificada sobre su propio
+// whisper_state. done() se llama desde un hilo del pool al terminar; ret es
+// el de whisper_full_with_state, o -1 si se canceló antes de empezar.
+// wait_ms es lo que esperó en la cola e infer_ms lo que tardó whisper.
+struct inference_job_t {
+    whisper_context *ctx;
+    whisper_state *state;
+    whisper_full_params params;
+    const float *samples;
+    int n_samples;
+    int ret;
+    std::chrono::steady_clock::time_point submitted, started;
+    double wait_ms;
+    double infer_ms;
+    void (*done)(inference_job_t *);
+    void *opaque;
+};
+
+// Hilos de inferencia compartidos por todos los filtros del proceso. Cada
+// trabajo usa además los n_threads de ggml de sus parámetros, así que el
+// tamaño útil es del orden de núcleos / n_threads. Los trabajos se atienden
+// en orden de llegada; cada filtro restablece el orden de sus resultados.
+class InferencePool {
+public:
+    static InferencePool &instance()
+    {
+        static InferencePool pool;
+        return pool;
+    }
+
+    // Cada filtro se registra con el tamaño que pide: el pool crece hasta el
+    // mayor de ellos y se detiene cuando se va el último. Un filtro no se va
+    // con trabajos pendientes. Con reserved_cpus > 0 los hilos se fijan a las
+    // CPU restantes; lo decide el primer filtro que arranca el pool. Devuelve
+    // false si se pidió fijar los hilos y no están fijados.
+    bool acquire(unsigned size, unsigned reserved_cpus)
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        users_++;
+        if (threads_.empty()) {
+            reserved_cpus_ = reserved_cpus;
+            pinned_ = reserved_cpus > 0;
+        }
+        while (threads_.size() < size) {
+            threads_.emplace_back(&InferencePool::run, this, generation_);
+            if (reserved_cpus_ > 0 && !pin_thread(threads_.back(), reserved_cpus_))
+                pinned_ = false;
+        }
+        return reserved_cpus == 0 || pinned_;
+    }
+
+    // Linux: fija el hilo a las CPU que el proceso tiene permitidas (taskset,
+    // cpuset) salvo las skip primeras. Los hilos que crea ggml dentro de
+    // whisper_full heredan la afinidad, así que esas CPU quedan libres para
+    // la decodificación y la salida de VLC.
+    static bool pin_thread(std::thread &t, unsigned skip)
+    {
+#if defined(__linux__)
+        cpu_set_t allowed, set;
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+            return false;
+        CPU_ZERO(&set);
+        unsigned seen = 0;
+        for (unsigned c = 0; c < CPU_SETSIZE; ++c)
+            if (CPU_ISSET(c, &allowed) && seen++ >= skip)
+                CPU_SET(c, &set);
+        if (CPU_COUNT(&set) == 0)
+            return false;
+        return pthread_setaffinity_np(t.native_handle(), sizeof(set), &set) == 0;
+#else
+        (void)t;
+        (void)skip;
+        return false;
+#endif
+    }
+
+    void release()
+    {
+        std::vector<std::thread> threads;
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            if (--users_ > 0) return;
+            // Los hilos de esta generación terminan aunque alguien vuelva a
+            // registrarse antes de que despierten
+            generation_++;
+            threads.swap(threads_);
+        }
+        cv_.notify_all();
+        for (std::thread &t : threads)
+            t.join();
+    }
+
+    void submit(inference_job_t *job)
+    {
+        job->submitted = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            queue_.push_back(job);
+        }
+        cv_.notify_one();
+    }
+
+private:
+    void run(uint64_t generation)
+    {
+        std::unique_lock<std::mutex> lock(lock_);
+        for (;;) {
+            cv_.wait(lock, [&] { return generation_ != generation || !queue_.empty(); });
+            if (generation_ != generation)
+                return;
+            inference_job_t *job = queue_.front();
+            queue_.pop_front();
+            lock.unlock();
+
+            // El trabajo de un filtro que se está cerrando no llega a empezar
+            const whisper_full_params &p = job->params;
+            job->started = std::chrono::steady_clock::now();
+            job->wait_ms = std::chrono::duration<double, std::milli>(job->started - job->submitted).count();
+            if (p.abort_callback && p.abort_callback(p.abort_callback_user_data)) {
+                job->ret = -1;
+                job->infer_ms = 0.0;
+            } else {
+                job->ret = whisper_full_with_state(job->ctx, job->state, job->params,
+                                                   job->samples, job->n_samples);
+                job->infer_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - job->started).count();
+            }
+            job->done(job);
+
+            lock.lock();
+        }
+    }
+
+    std::mutex lock_;
+    std::condition_variable cv_;
+    std::deque<inference_job_t *> queue_;
+    std::vector<std::thread> threads_;
+    unsigned users_ = 0;
+    unsigned reserved_cpus_ = 0;
+    bool pinned_ = false;
+    uint64_t generation_ = 0;
+};
+
+#endif
@@ -0,0 +1,210 @@
+#ifndef WHISPER_SUBS_MEL_FRONTEND_H
+#define WHISPER_SUBS_MEL_FRONTEND_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "dsp_kernels.h"
+
+// Espectrograma log-mel de whisper calculado de forma incremental.
+//
+// whisper_full recalcula el mel de toda la ventana en cada llamada, incluido
+// el solapamiento que ya analizó la vez anterior. Aquí cada trama se calcula
+// una sola vez y se guarda en bruto (log10): al lanzar una ventana se calculan
+// solo las tramas nuevas desde la anterior y el resto se normaliza y se copia
+// con whisper_set_mel_with_state.
+//
+// La trama f está centrada en la muestra f * HOP, como las de whisper para
+// ventanas que empiezan en un múltiplo de HOP. La FFT de 400 se descompone
+// en 16 DFT de 25 sobre x[16m + r] más una combinación con twiddles; ambos
+// pasos recorren 16 valores contiguos por iteración y se vectorizan.
+class MelFrontend {
+public:
+    static const unsigned N_FFT = 400;
+    static const unsigned HOP = 160;
+    static const unsigned N_BINS = N_FFT / 2 + 1;   // 201
+    static const unsigned PAD_FRAMES = 3000;        // whisper rellena 30 s
+
+    // filters: n_mel x N_BINS, tal como vienen en el modelo. max_frames es
+    // cuántas tramas hacia atrás siguen disponibles para una ventana.
+    bool init(const std::vector<float> &filters, unsigned n_mel, size_t max_frames)
+    {
+        const double PI = 3.14159265358979323846;
+        if (n_mel == 0 || filters.size() != (size_t)n_mel * N_BINS)
+            return false;
+
+        for (unsigned n = 0; n < N_FFT; ++n)
+            hann_[n] = (float)(0.5 * (1.0 - std::cos(2.0 * PI * n / N_FFT)));
+        for (unsigned k = 0; k < RADIX; ++k)
+            for (unsigned m = 0; m < RADIX; ++m) {
+                const double a = 2.0 * PI * ((k * m) % RADIX) / RADIX;
+                dft_cos_[k][m] = (float)std::cos(a);
+                dft_sin_[k][m] = (float)std::sin(a);
+            }
+        for (unsigned k = 0; k < N_BINS; ++k)
+            for (unsigned r = 0; r < SPLIT; ++r) {
+                const double a = 2.0 * PI * ((r * k) % N_FFT) / N_FFT;
+                tw_cos_[k][r] = (float)std::cos(a);
+                tw_sin_[k][r] = (float)std::sin(a);
+            }
+
+        n_mel_ = n_mel;
+        filters_.assign((size_t)n_mel * BINS_PAD, 0.0f);
+        for (unsigned j = 0; j < n_mel; ++j)
+            memcpy(&filters_[(size_t)j * BINS_PAD], &filters[(size_t)j * N_BINS], N_BINS * sizeof(float));
+
+        dot_ = dsp_dot();
+        max_frames_ = max_frames;
+        frames_.assign(max_frames * n_mel, 0.0f);
+        next_ = 0;
+        return true;
+    }
+
+    unsigned n_mel() const { return n_mel_; }
+
+    // Primera muestra que necesita la próxima trama
+    size_t pending_from() const { return next_ * HOP > N_FFT / 2 ? next_ * HOP - N_FFT / 2 : 0; }
+
+    // Calcula las tramas que ya tienen todo su audio. s apunta a la muestra
+    // absoluta first y hay n disponibles; lo anterior a first ya no existe
+    // (inicio del stream o audio descartado) y cuenta como silencio.
+    void update(const float *s, size_t first, size_t n)
+    {
+        const size_t end = first + n;
+        if (next_ * HOP + N_FFT / 2 < first)
+            next_ = first / HOP;
+
+        float x[N_FFT];
+        while (next_ * HOP + N_FFT / 2 <= end) {
+            const int64_t lo = (int64_t)(next_ * HOP) - N_FFT / 2;
+            for (unsigned i = 0; i < N_FFT; ++i) {
+                const int64_t idx = lo + i;
+                x[i] = idx < (int64_t)first ? 0.0f : s[idx - (int64_t)first];
+            }
+            compute_frame(x, &frames_[(next_ % max_frames_) * n_mel_]);
+            next_++;
+        }
+    }
+
+    // Mel normalizado de la ventana [start, start + n_samples), en el formato
+    // de whisper_set_mel_with_state (n_mel filas de n_len) y con el relleno
+    // de 30 s que añade whisper. Devuelve n_len, o 0 si la ventana no está
+    // alineada o sus tramas no están (todavía o ya) disponibles.
+    int window(size_t start, size_t n_samples, std::vector<float> &out) const
+    {
+        if (start % HOP || n_samples < N_FFT)
+            return 0;
+        const size_t f0 = start / HOP;
+        const size_t n_frames = 1 + (n_samples - N_FFT / 2) / HOP;
+        if (f0 + n_frames > next_ || next_ - f0 > max_frames_)
+            return 0;
+
+        // Mismo recorte y escala que whisper: máximo - 8 dB, (x + 4) / 4
+        float mmax = -10.0f;
+        for (size_t i = 0; i < n_frames; ++i) {
+            const float *fr = &frames_[((f0 + i) % max_frames_) * n_mel_];
+            for (unsigned j = 0; j < n_mel_; ++j)
+                if (fr[j] > mmax) mmax = fr[j];
+        }
+        const float floor_db = mmax - 8.0f;
+        const float pad = ((-10.0f > floor_db ? -10.0f : floor_db) + 4.0f) / 4.0f;
+
+        const size_t n_len = n_frames + PAD_FRAMES;
+        out.resize((size_t)n_mel_ * n_len);
+        for (size_t i = 0; i < n_frames; ++i) {
+            const float *fr = &frames_[((f0 + i) % max_frames_) * n_mel_];
+            for (unsigned j = 0; j < n_mel_; ++j) {
+                const float v = fr[j] > floor_db ? fr[j] : floor_db;
+                out[(size_t)j * n_len + i] = (v + 4.0f) / 4.0f;
+            }
+        }
+        for (unsigned j = 0; j < n_mel_; ++j)
+            std::fill(&out[(size_t)j * n_len + n_frames], &out[(size_t)j * n_len + n_len], pad);
+        return (int)n_len;
+    }
+
+private:
+    static const unsigned SPLIT = 16;   // N_FFT = SPLIT * RADIX
+    static const unsigned RADIX = 25;
+    static const unsigned BINS_PAD = (N_BINS + 7) & ~7u;  // para dsp_dot
+
+    void compute_frame(const float *x, float *out)
+    {
+        float xw[N_FFT];
+        for (unsigned n = 0; n < N_FFT; ++n)
+            xw[n] = x[n] * hann_[n];
+
+        // Y[k][r] = DFT25 de xw[16m + r]
+        float yre[RADIX][SPLIT], yim[RADIX][SPLIT];
+        for (unsigned k = 0; k < RADIX; ++k) {
+            float *re = yre[k], *im = yim[k];
+            for (unsigned r = 0; r < SPLIT; ++r)
+                re[r] = im[r] = 0.0f;
+            for (unsigned m = 0; m < RADIX; ++m) {
+                const float c = dft_cos_[k][m], s = dft_sin_[k][m];
+                const float *xm = &xw[m * SPLIT];
+                for (unsigned r = 0; r < SPLIT; ++r) {
+                    re[r] += c * xm[r];
+                    im[r] -= s * xm[r];
+                }
+            }
+        }
+
+        // X[k] = sum_r W400^(rk) Y[k mod 25][r]; solo interesa la potencia
+        alignas(32) float power[BINS_PAD];
+        for (unsigned k = 0; k < N_BINS; ++k) {
+            const float *re = yre[k % RADIX], *im = yim[k % RADIX];
+            const float *c = tw_cos_[k], *s = tw_sin_[k];
+            float xr = 0.0f, xi = 0.0f;
+            for (unsigned r = 0; r < SPLIT; ++r) {
+                xr += re[r] * c[r] + im[r] * s[r];
+                xi += im[r] * c[r] - re[r] * s[r];
+            }
+            power[k] = xr * xr + xi * xi;
+        }
+        for (unsigned k = N_BINS; k < BINS_PAD; ++k)
+            power[k] = 0.0f;
+
+        for (unsigned j = 0; j < n_mel_; ++j) {
+            const float v = dot_(&filters_[(size_t)j * BINS_PAD], power, BINS_PAD);
+            out[j] = std::log10(v > 1e-10f ? v : 1e-10f);
+        }
+    }
+
+    float hann_[N_FFT];
+    float dft_cos_[RADIX][RADIX], dft_sin_[RADIX][RADIX];
+    float tw_cos_[N_BINS][SPLIT], tw_sin_[N_BINS][SPLIT];
+    std::vector<float> filters_;    // n_mel x BINS_PAD
+    dot_fn dot_ = dot_scalar;
+    unsigned n_mel_ = 0;
+
+    std::vector<float> frames_;     // max_frames x n_mel, circular
+    size_t max_frames_ = 0;
+    size_t next_ = 0;               // próxima trama a calcular
+};
+
+// Banco de filtros mel del fichero del modelo: tras la cabecera (magic y 11
+// hiperparámetros int32) vienen n_mel, n_fft y n_mel * n_fft floats.
+static inline bool mel_read_filters(const char *path, std::vector<float> &filters, unsigned *n_mel)
+{
+    std::ifstream f(path, std::ios::binary);
+    uint32_t magic;
+    int32_t hparams[11], dims[2];
+    if (!f.read((char *)&magic, sizeof(magic)) || !f.read((char *)hparams, sizeof(hparams))
+        || !f.read((char *)dims, sizeof(dims)))
+        return false;
+    if (magic != 0x67676d6c || dims[0] <= 0 || dims[0] > 512 || dims[1] != (int32_t)MelFrontend::N_BINS)
+        return false;
+
+    filters.resize((size_t)dims[0] * (size_t)dims[1]);
+    if (!f.read((char *)filters.data(), filters.size() * sizeof(float)))
+        return false;
+    *n_mel = (unsigned)dims[0];
+    return true;
+}
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef WHISPER_SUBS_MODEL_CACHE_H
+#define WHISPER_SUBS_MODEL_CACHE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "whisper.h"
+
+// Modelos cargados en el proceso, compartidos entre instancias del filtro.
+// Los pesos son de solo lectura durante la inferencia; cada filtro decodifica
+// con su propio whisper_state, así que N streams cuestan una sola copia.
+//
+// VLC cierra el filtro de la pista anterior antes de abrir el de la nueva,
+// así que el último modelo que se queda sin usuarios se conserva hasta
+// MODEL_CACHE_LINGER: un cambio de pista o de elemento de la lista no vuelve
+// a leerlo del disco. Como mucho queda uno así: se libera al cargar otro o,
+// pasado ese tiempo, en la siguiente operación de la caché.
+//
+// La carga se hace fuera del lock del mapa (la entrada queda marcada como
+// "cargando"), para que soltar otro modelo desde el hilo de VLC no espere a
+// una lectura de varios segundos; quien pide el mismo modelo mientras tanto
+// espera a esa lectura en vez de repetirla.
+
+static const std::chrono::seconds MODEL_CACHE_LINGER(60);
+
+typedef std::tuple<std::string, bool, bool, int, bool> model_key_t;
+
+struct model_entry_t {
+    whisper_context *ctx;   // NULL mientras se carga
+    unsigned refs;
+    bool loading;
+    std::chrono::steady_clock::time_point idle_since;  // refs == 0
+};
+
+static inline std::mutex &model_cache_lock()
+{
+    static std::mutex lock;
+    return lock;
+}
+
+static inline std::condition_variable &model_cache_loaded()
+{
+    static std::condition_variable cv;
+    return cv;
+}
+
+static inline std::map<model_key_t, model_entry_t> &model_cache_map()
+{
+    static std::map<model_key_t, model_entry_t> cache;
+    return cache;
+}
+
+// Con el lock tomado: saca del mapa los modelos sin usuarios salvo keep, y
+// keep también si ya pasó su tiempo; se liberan después, fuera del lock
+static inline void model_cache_collect(const whisper_context *keep, std::vector<whisper_context *> &out)
+{
+    const auto now = std::chrono::steady_clock::now();
+    auto &cache = model_cache_map();
+    for (auto it = cache.begin(); it != cache.end(); ) {
+        const model_entry_t &e = it->second;
+        if (e.refs == 0 && !e.loading && (e.ctx != keep || now - e.idle_since > MODEL_CACHE_LINGER)) {
+            out.push_back(e.ctx);
+            it = cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+static inline void model_cache_free(const std::vector<whisper_context *> &ctxs)
+{
+    for (whisper_context *ctx : ctxs)
+        whisper_free(ctx);
+}
+
+// Devuelve el contexto de path con cparams, cargándolo (sin estado) si no
+// está ya en memoria. *shared indica si ya estaba cargado. NULL si falla la
+// carga.
+static inline whisper_context *model_cache_acquire(const char *path, const whisper_context_params &cparams,
+                                                   bool *shared)
+{
+    const model_key_t key(path, cparams.use_gpu, cparams.flash_attn,
+                          cparams.gpu_device, cparams.dtw_token_timestamps);
+    std::vector<whisper_context *> unused;
+
+    std::unique_lock<std::mutex> lock(model_cache_lock());
+    auto &cache = model_cache_map();
+    auto it = cache.find(key);
+    model_cache_loaded().wait(lock, [&] {
+        it = cache.find(key);
+        return it == cache.end() || !it->second.loading;
+    });
+    if (it != cache.end()) {
+        it->second.refs++;
+        *shared = true;
+        whisper_context *ctx = it->second.ctx;
+        model_cache_collect(ctx, unused);
+        lock.unlock();
+        model_cache_free(unused);
+        return ctx;
+    }
+
+    // Un modelo distinto: el que esperaba sin usuarios ya no hace falta
+    *shared = false;
+    cache[key] = model_entry_t{ nullptr, 1, true, {} };
+    model_cache_collect(nullptr, unused);
+    lock.unlock();
+    model_cache_free(unused);
+
+    whisper_context *ctx = whisper_init_from_file_with_params_no_state(path, cparams);
+
+    lock.lock();
+    it = cache.find(key);
+    if (ctx) {
+        it->second.ctx = ctx;
+        it->second.loading = false;
+    } else {
+        // Quien esperaba lo intenta por su cuenta
+        cache.erase(it);
+    }
+    lock.unlock();
+    model_cache_loaded().notify_all();
+    return ctx;
+}
+
+// Suelta una referencia; sin usuarios, el modelo se conserva un tiempo por
+// si otro filtro lo pide enseguida
+static inline void model_cache_release(whisper_context *ctx)
+{
+    std::vector<whisper_context *> unused;
+    {
+        std::lock_guard<std::mutex> guard(model_cache_lock());
+        for (auto &kv : model_cache_map()) {
+            model_entry_t &e = kv.second;
+            if (e.ctx != ctx) continue;
+            if (--e.refs == 0)
+                e.idle_since = std::chrono::steady_clock::now();
+            break;
+        }
+        model_cache_collect(ctx, unused);
+    }
+    model_cache_free(unused);
+}
+
+#endif
@@ -0,0 +1,168 @@
+#ifndef WHISPER_SUBS_RESAMPLER_H
+#define WHISPER_SUBS_RESAMPLER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "dsp_kernels.h"
+
+// Tabla polifásica de un filtro sinc con ventana de Kaiser para in_rate -> out_rate.
+// Se calcula una sola vez por par de tasas y se comparte entre instancias.
+struct ResamplerTable {
+    unsigned up = 1;    // L: fases
+    unsigned down = 1;  // M: avance de entrada por salida, en 1/L muestras
+    unsigned taps = 0;  // coeficientes por fase (múltiplo de 8)
+    std::vector<float> coefs; // up * taps
+};
+
+static inline double resampler_bessel_i0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 32; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+static inline std::shared_ptr<const ResamplerTable> resampler_build_table(unsigned in_rate, unsigned out_rate)
+{
+    const unsigned ZERO_CROSSINGS = 16;
+    const double ROLLOFF = 0.92;
+    const double BETA = 8.0;
+    const double PI = 3.14159265358979323846;
+
+    unsigned a = in_rate, b = out_rate;
+    while (b) { unsigned t = a % b; a = b; b = t; }
+
+    auto t = std::make_shared<ResamplerTable>();
+    t->up = out_rate / a;
+    t->down = in_rate / a;
+
+    // Frecuencia de corte en ciclos por muestra de entrada
+    const double fc = 0.5 * ROLLOFF * (out_rate < in_rate ? (double)out_rate / in_rate : 1.0);
+    const double half = ZERO_CROSSINGS / (2.0 * fc);
+    t->taps = ((unsigned)std::ceil(2.0 * half) + 7) & ~7u;
+    t->coefs.assign((size_t)t->up * t->taps, 0.0f);
+
+    const double i0_beta = resampler_bessel_i0(BETA);
+    for (unsigned p = 0; p < t->up; ++p) {
+        float *h = &t->coefs[(size_t)p * t->taps];
+        double sum = 0.0;
+        for (unsigned j = 0; j < t->taps; ++j) {
+            // Distancia entre la posición de salida y el tap j
+            const double x = (double)p / t->up + (double)(t->taps / 2 - 1) - j;
+            if (std::fabs(x) >= half) continue;
+            const double arg = 2.0 * fc * x;
+            const double sinc = (x == 0.0) ? 1.0 : std::sin(PI * arg) / (PI * arg);
+            const double r = x / half;
+            const double w = resampler_bessel_i0(BETA * std::sqrt(1.0 - r * r)) / i0_beta;
+            h[j] = (float)(2.0 * fc * sinc * w);
+            sum += h[j];
+        }
+        // Ganancia unitaria en DC para cada fase
+        for (unsigned j = 0; j < t->taps; ++j)
+            h[j] = (float)(h[j] / sum);
+    }
+    return t;
+}
+
+static inline std::shared_ptr<const ResamplerTable> resampler_get_table(unsigned in_rate, unsigned out_rate)
+{
+    static std::mutex lock;
+    static std::map<std::pair<unsigned, unsigned>, std::shared_ptr<const ResamplerTable>> cache;
+
+    std::lock_guard<std::mutex> guard(lock);
+    auto &slot = cache[std::make_pair(in_rate, out_rate)];
+    if (!slot)
+        slot = resampler_build_table(in_rate, out_rate);
+    return slot;
+}
+
+// Resampler FIR polifásico con estado: process() puede llamarse con bloques
+// de cualquier tamaño y el resultado es idéntico a procesar la señal entera.
+// No reserva memoria después de init().
+class Resampler {
+public:
+    // simd = false fuerza el producto escalar (para comparar variantes)
+    bool init(unsigned in_rate, unsigned out_rate, bool simd = true)
+    {
+        passthrough_ = (in_rate == out_rate);
+        if (passthrough_) return true;
+
+        table_ = resampler_get_table(in_rate, out_rate);
+        dot_ = simd ? dsp_dot() : dot_scalar;
+        buf_.assign(table_->taps + BLOCK, 0.0f);
+        reset();
+        return true;
+    }
+
+    void reset()
+    {
+        if (passthrough_) return;
+        // Relleno inicial: la salida 0 queda centrada en la entrada 0
+        std::fill(buf_.begin(), buf_.end(), 0.0f);
+        fill_ = table_->taps / 2 - 1;
+        base_ = 0;
+        phase_ = 0;
+    }
+
+    // Máximo de muestras que puede producir process() para n_in de entrada
+    size_t max_output(size_t n_in) const
+    {
+        if (passthrough_) return n_in;
+        return (size_t)(((unsigned long long)n_in * table_->up) / table_->down) + 2;
+    }
+
+    size_t process(const float *in, size_t n_in, float *out)
+    {
+        if (passthrough_) {
+            memcpy(out, in, n_in * sizeof(float));
+            return n_in;
+        }
+
+        const unsigned taps = table_->taps, up = table_->up, down = table_->down;
+        const float *coefs = table_->coefs.data();
+        size_t n_out = 0;
+
+        while (n_in > 0) {
+            size_t n = buf_.size() - fill_;
+            if (n > n_in) n = n_in;
+            memcpy(&buf_[fill_], in, n * sizeof(float));
+            fill_ += n; in += n; n_in -= n;
+
+            while (base_ + taps <= fill_) {
+                out[n_out++] = dot_(&buf_[base_], &coefs[(size_t)phase_ * taps], taps);
+                phase_ += down;
+                base_ += phase_ / up;
+                phase_ %= up;
+            }
+
+            // Conserva solo la historia que necesitan las próximas salidas
+            const size_t consumed = base_ < fill_ ? base_ : fill_;
+            memmove(&buf_[0], &buf_[consumed], (fill_ - consumed) * sizeof(float));
+            fill_ -= consumed;
+            base_ -= consumed;
+        }
+        return n_out;
+    }
+
+private:
+    static const size_t BLOCK = 4096;
+
+    bool passthrough_ = true;
+    std::shared_ptr<const ResamplerTable> table_;
+    dot_fn dot_ = dot_scalar;
+    std::vector<float> buf_;
+    size_t fill_ = 0;
+    size_t base_ = 0;
+    unsigned phase_ = 0;
+};
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef WHISPER_SUBS_SPSC_RING_H
+#define WHISPER_SUBS_SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+
+// Ring buffer single-producer/single-consumer sin bloqueos.
+// Productor: hilo de audio de VLC (ProcessAudio). Consumidor: WhisperWorker.
+// Toda la memoria se reserva en init(); write() nunca bloquea ni reserva.
+//
+// Cada muestra se escribe dos veces (en pos y en pos + capacity), así que
+// cualquier tramo de hasta capacity muestras a partir de la cola es contiguo
+// en memoria: el consumidor lo lee con view_at() sin copiar, y el solapamiento
+// entre ventanas se conserva simplemente no consumiéndolo.
+class SpscRing {
+public:
+    bool init(size_t min_capacity)
+    {
+        size_t cap = 1;
+        while (cap < min_capacity) cap <<= 1;
+        data_.reset(new(std::nothrow) float[2 * cap]);
+        if (!data_) return false;
+        mask_ = cap - 1;
+        head_.store(0, std::memory_order_relaxed);
+        tail_.store(0, std::memory_order_relaxed);
+        return true;
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+    // Índices absolutos (cuentan muestras desde init): el productor escribe
+    // en write_index(), la ventana del consumidor empieza en read_index()
+    size_t write_index() const { return head_.load(std::memory_order_relaxed); }
+    size_t read_index() const { return tail_.load(std::memory_order_relaxed); }
+
+    // Productor. Devuelve cuántas muestras cupieron (el resto se descarta).
+    size_t write(const float *src, size_t n)
+    {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        const size_t free_space = capacity() - (head - tail);
+        if (n > free_space) n = free_space;
+
+        const size_t pos = head & mask_;
+        const size_t first = (n < capacity() - pos) ? n : capacity() - pos;
+        memcpy(&data_[pos], src, first * sizeof(float));
+        memcpy(&data_[0], src + first, (n - first) * sizeof(float));
+        // Espejo
+        memcpy(&data_[pos + capacity()], src, first * sizeof(float));
+        memcpy(&data_[capacity()], src + first, (n - first) * sizeof(float));
+
+        head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    // Muestras disponibles para leer (válido desde ambos lados).
+    size_t size() const
+    {
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        return head_.load(std::memory_order_acquire) - tail;
+    }
+
+    // Consumidor: puntero contiguo a *n muestras desde el índice absoluto
+    // index (>= cola), sin consumirlas. *n se recorta a las disponibles.
+    // Válido mientras index siga por encima de la cola (ver consume()).
+    const float *view_at(size_t index, size_t *n) const
+    {
+        const size_t avail = head_.load(std::memory_order_acquire) - index;
+        if (*n > avail) *n = avail;
+        return &data_[index & mask_];
+    }
+
+    // Consumidor: libera n muestras para el productor.
+    void consume(size_t n)
+    {
+        const size_t avail = size();
+        if (n > avail) n = avail;
+        tail_.store(tail_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    }
+
+private:
+    std::unique_ptr<float[]> data_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+};
+
+// Cola SPSC de tamaño fijo para elementos pequeños (p. ej. marcas de tiempo)
+template <typename T, size_t N>
+class SpscQueue {
+    static_assert((N & (N - 1)) == 0, "N debe ser potencia de 2");
+public:
+    // Productor. Devuelve false si la cola está llena.
+    bool push(const T &v)
+    {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == N)
+            return false;
+        items_[head & (N - 1)] = v;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumidor
+    size_t size() const
+    {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_relaxed);
+    }
+    const T &peek(size_t k) const { return items_[(tail_.load(std::memory_order_relaxed) + k) & (N - 1)]; }
+    void pop() { tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+private:
+    T items_[N];
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+};
+
+#endif
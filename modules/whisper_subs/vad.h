@@ -0,0 +1,117 @@
+#ifndef WHISPER_SUBS_VAD_H
+#define WHISPER_SUBS_VAD_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// Detector de actividad de voz por energía sobre audio a 16 kHz.
+// Trabaja en tramas de 20 ms y sigue un suelo de ruido adaptativo, de modo
+// que una trama es voz si supera el suelo en threshold_db (y un mínimo absoluto).
+class Vad {
+public:
+    static const size_t FRAME = 320;             // 20 ms
+    static const size_t PAUSE_FRAMES = 5;        // 100 ms
+
+    void init(float threshold_db, size_t max_samples)
+    {
+        threshold_db_ = threshold_db;
+        noise_db_ = MIN_DB;
+        energies_.reserve(max_samples / FRAME + 1);
+        sorted_.reserve(max_samples / FRAME + 1);
+    }
+
+    // Nivel a partir del cual una trama cuenta como voz
+    float speech_db() const
+    {
+        const float t = noise_db_ + threshold_db_;
+        return t > MIN_SPEECH_DB ? t : MIN_SPEECH_DB;
+    }
+
+    // Analiza una ventana completa, actualiza el suelo de ruido y devuelve
+    // si hay suficientes tramas de voz para que merezca la pena transcribirla
+    bool has_speech(const float *s, size_t n)
+    {
+        analyze(s, n);
+        if (energies_.empty()) return false;
+
+        // El percentil 10 de la ventana estima el ruido de fondo; baja rápido
+        // y sube despacio para no confundir voz continua con ruido
+        sorted_.assign(energies_.begin(), energies_.end());
+        std::nth_element(sorted_.begin(), sorted_.begin() + sorted_.size() / 10, sorted_.end());
+        const float floor_db = sorted_[sorted_.size() / 10];
+        if (floor_db < noise_db_) noise_db_ = floor_db;
+        else noise_db_ += 0.1f * (floor_db - noise_db_);
+
+        const float thold = speech_db();
+        size_t voiced = 0;
+        for (float e : energies_)
+            if (e > thold) ++voiced;
+        return voiced * 10 >= energies_.size(); // >= 10 % de tramas con voz
+    }
+
+    // Devuelve true si los últimos ms de la ventana están en silencio
+    bool ends_in_pause(const float *s, size_t n, int ms)
+    {
+        const size_t len = (size_t)ms * 16;
+        if (n < len) return false;
+        analyze(s + n - len, len);
+        const float thold = speech_db();
+        for (float e : energies_)
+            if (e > thold) return false;
+        return true;
+    }
+
+    // Busca la pausa más silenciosa (PAUSE_FRAMES tramas) entre las muestras
+    // from y to. Devuelve la posición de corte o 0 si no hay pausa real.
+    size_t find_pause(const float *s, size_t from, size_t to)
+    {
+        if (to <= from || to - from < FRAME * PAUSE_FRAMES) return 0;
+        analyze(s + from, to - from);
+
+        float best = speech_db() * PAUSE_FRAMES;
+        size_t best_pos = 0;
+        float run = 0.0f;
+        for (size_t i = 0; i < energies_.size(); ++i) {
+            run += energies_[i];
+            if (i >= PAUSE_FRAMES) run -= energies_[i - PAUSE_FRAMES];
+            if (i + 1 >= PAUSE_FRAMES && run < best) {
+                best = run;
+                // Corte en el centro de la pausa
+                best_pos = from + (i + 1 - PAUSE_FRAMES / 2) * FRAME;
+            }
+        }
+        return best_pos;
+    }
+
+private:
+    static constexpr float MIN_DB = -100.0f;
+    static constexpr float MIN_SPEECH_DB = -55.0f;
+
+    void analyze(const float *s, size_t n)
+    {
+        energies_.clear();
+        for (size_t f = 0; f + FRAME <= n; f += FRAME) {
+            const float *p = s + f;
+            float mean = 0.0f;
+            for (size_t i = 0; i < FRAME; ++i) mean += p[i];
+            mean /= FRAME;
+
+            float energy = 0.0f;
+            for (size_t i = 0; i < FRAME; ++i) {
+                const float v = p[i] - mean; // sin componente DC
+                energy += v * v;
+            }
+            energy /= FRAME;
+            energies_.push_back(energy > 1e-10f ? 10.0f * std::log10(energy) : MIN_DB);
+        }
+    }
+
+    float threshold_db_ = 9.0f;
+    float noise_db_ = MIN_DB;
+    std::vector<float> energies_;
+    std::vector<float> sorted_;
+};
+
+#endif
@@ -1,5 +1,9 @@
 
 #ifdef _WIN32
+// winsock2.h trae windows.h, que sin esto define min y max como macros
+# ifndef NOMINMAX
+#  define NOMINMAX
+# endif
 # include <basetsd.h>
 typedef SSIZE_T ssize_t;
 # include <winsock2.h>
@@ -12,13 +16,28 @@ typedef SSIZE_T ssize_t;
 #include <vlc_plugin.h>
 #include <vlc_filter.h>
 #include <vlc_block.h>
+#include <vlc_subpicture.h>
 
+#include <algorithm>
+#include <deque>
 #include <vector>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <chrono>
 #include <string>
+#include <cstdlib>
+#include <cstring>
 #include "whisper.h"
+#include "spsc_ring.h"
+#include "resampler.h"
+#include "vad.h"
+#include "dsp_kernels.h"
+#include "caption_board.h"
+#include "model_cache.h"
+#include "inference_pool.h"
+#include "mel_frontend.h"
 
 #ifndef MODULE_STRING
 # define MODULE_STRING "whisper_subs"
@@ -28,32 +47,154 @@ typedef SSIZE_T ssize_t;
 # define N_(str) (str)
 #endif
 
-struct shared_state_t {
-    std::mutex lock;
-    std::string current_text;
-    mtime_t last_update = 0;
+// Puente entre los workers de inferencia y el sub source: el tablero del
+// reproductor al que pertenece el objeto. En VLC 3 su salida de audio y la de
+// vídeo cuelgan del mismo "media player" (libvlc) o "playlist" (interfaz de
+// VLC); sin ninguno de los dos, de la raíz.
+static CaptionBoard *AcquireCaptionBoard(vlc_object_t *obj)
+{
+    vlc_object_t *owner = obj;
+    for (vlc_object_t *o = obj; o; o = o->obj.parent) {
+        owner = o;
+        const char *type = o->obj.psz_object_type;
+        if (type && (!strcmp(type, "media player") || !strcmp(type, "playlist")))
+            break;
+    }
+    return caption_board_acquire(owner);
+}
+
+// Qué hacer cuando la inferencia no alcanza al tiempo real
+enum overload_policy_t {
+    OVERLOAD_DROP_OLDEST,   // descarta el audio más antiguo por encima del máximo
+    OVERLOAD_SKIP_TO_LIVE,  // salta al audio más reciente
+    OVERLOAD_DEGRADE,       // cambia al modelo de respaldo y después descarta
+};
+
+// Fecha de una muestra del ring: la muestra index sonó en date
+struct ts_anchor_t {
+    size_t index;
+    mtime_t date;
+};
+
+struct filter_sys_t;
+
+// Ventana en vuelo: audio [start, start + n) del ring decodificándose en el
+// pool sobre un estado propio
+struct window_job_t {
+    inference_job_t job;
+    filter_sys_t *p_sys;
+    whisper_state *state = nullptr;
+    std::vector<whisper_token> prompt;  // copia: el historial cambia mientras tanto
+    size_t start, n, release;
+    bool is_final;
+    std::atomic<bool> done{true};       // false mientras está en vuelo
+
+    // Tiempos de la ventana (ms): mel_ms y depth los anota el coordinador al
+    // enviarla; el resto, los callbacks de whisper desde el hilo del pool
+    double mel_ms;
+    size_t depth;                       // audio pendiente al enviarla, incluida ella
+    std::chrono::steady_clock::time_point t_encode;
+    bool encoding;
+    double pre_encode_ms, encode_ms;
 };
-static shared_state_t g_state;
 
 struct filter_sys_t {
-    whisper_context *ctx = nullptr;
-    std::vector<float> pcm_buffer; 
-    std::mutex buffer_mutex;
+    whisper_context *ctx = nullptr;     // compartido, ver model_cache.h
+    CaptionBoard *captions = nullptr;   // el del reproductor, ver AcquireCaptionBoard
+    std::vector<window_job_t> windows;  // una por ventana en vuelo
+    unsigned pool_size;
+    unsigned reserved_cpus;             // CPU que no usa la inferencia (0 = sin fijar)
+    std::string model_path;
+    whisper_context_params cparams;
+    whisper_full_params wparams;        // comunes a todas las ventanas salvo el prompt
+    SpscRing pcm_ring;              // audio mono a 16 kHz
+    convert_fn convert;             // formato de entrada -> float (NULL si FL32)
+    size_t sample_bytes;
+    std::vector<float> ingest_f32;  // sub-bloque convertido, aún entrelazado
+    downmix_fn downmix;             // entrelazado -> mono
+    std::vector<float> downmix_w;   // un peso por canal
+    Resampler resampler;            // solo lo usa el hilo de audio
+    std::vector<float> ingest16;    // salida del resampler por sub-bloque
     std::thread worker_thread;
-    bool running;
+    std::atomic<bool> running{false};
+    // El worker carga el modelo; mientras tanto el audio se acumula en el
+    // ring. Si la carga falla se apaga y el filtro solo deja pasar el audio.
+    std::atomic<bool> ingest{true};
+
+    // Despertar del worker: espera en wake_cv mientras worker_idle está activo;
+    // el hilo de audio solo toma wake_mutex si el worker está dormido y ya hay
+    // wake_samples disponibles en el ring
+    std::mutex wake_mutex;
+    std::condition_variable wake_cv;
+    std::atomic<bool> worker_idle{false};
+    std::atomic<size_t> wake_samples{0};
+
+    // Límite de audio pendiente y contadores de audio perdido (muestras a 16 kHz)
+    size_t max_backlog;
+    overload_policy_t overload;
+    std::string fallback_model;
+    std::atomic<uint64_t> dropped_overload{0};  // lo escribe solo el worker
+    std::atomic<uint64_t> dropped_overrun{0};   // ring lleno, solo el hilo de audio
+
+    // Tiempo total del hilo de audio en ProcessAudio (conversión, downmix y
+    // resampling); el worker lo reparte entre ventanas por diferencias
+    std::atomic<uint64_t> ingest_ns{0};
+
+    // Línea de tiempo: el hilo de audio publica una marca solo cuando la
+    // fecha de un bloque no cuadra con la que se deduce de la marca anterior
+    // (inicio, saltos, audio descartado), así que suelen ser muy pocas
+    SpscQueue<ts_anchor_t, 256> anchors;
+    unsigned in_rate;
+    uint64_t in_samples = 0;            // hilo de audio: entrada y salida
+    uint64_t out_samples = 0;           // totales del resampler
+    ts_anchor_t last_anchor = { 0, VLC_TS_INVALID };    // hilo de audio
+    ts_anchor_t base_anchor = { 0, VLC_TS_INVALID };    // worker
+
     std::string language;
     bool translate;
     int n_threads;
+    bool auto_threads;  // whisper-threads = 0: n_threads se ajusta según la carga
+    int max_threads;
     int chunk_size;
     int keep_size;
+    int step_ms;      // > 0: modo streaming
+    int length_ms;
+    bool vad;
+    float vad_threshold;
     bool diarize;
+    bool carry_context;
+    bool fit_audio_ctx;
+    bool mel_frontend;
+
+    // Mel incremental (solo el worker); use_mel es false si el modelo no
+    // trae un banco de filtros utilizable y whisper calcula el suyo
+    MelFrontend mel;
+    bool use_mel = false;
+    std::vector<float> mel_window;
 };
 
 extern "C" {
     static int  OpenAudio (vlc_object_t *);
     static void CloseAudio(vlc_object_t *);
+    static int  OpenSub   (vlc_object_t *);
+    static void CloseSub  (vlc_object_t *);
 }
 
+static const char *const ppsz_overload_values[] = {
+    "drop-oldest", "skip-to-live", "degrade"
+};
+static const char *const ppsz_overload_texts[] = {
+    N_("Drop oldest audio"), N_("Skip to live"), N_("Switch to fallback model")
+};
+
+static const char *const ppsz_downmix_values[] = {
+    "first", "mean", "center", "itu", "custom"
+};
+static const char *const ppsz_downmix_texts[] = {
+    N_("First channel"), N_("Mean of all channels"), N_("Center channel"),
+    N_("ITU-R BS.775 downmix"), N_("Custom weights")
+};
+
 vlc_module_begin ()
     set_description(N_("Whisper Audio-to-Text (Audio Filter)"))
     set_shortname(N_("Whisper ASR"))
@@ -65,120 +206,1042 @@ vlc_module_begin ()
     add_string("whisper-language", "auto", N_("Inference language"), N_("ISO 639-1 language code (e.g. 'es', 'en', 'fr') or 'auto'"), false)
     add_bool("whisper-translate", false, N_("Translate to English"), N_("Translate the transcribed text to English"), false)
     add_bool("whisper-use-gpu", true, N_("Use GPU"), N_("Use GPU for inference if available"), false)
+    add_integer("whisper-pool-size", 0, N_("Inference pool size"), N_("Windows decoded concurrently across all streams of the process (0 = cores / threads)"), false)
+    add_integer("whisper-max-inflight", 1, N_("Windows in flight per stream"), N_("Windows of this stream that may be decoded concurrently; above 1 the prompt lags behind"), false)
     add_bool("whisper-flash-attn", false, N_("Flash Attention"), N_("Use Flash Attention (speeds up inference, requires compatible GPU)"), false)
-    add_integer("whisper-threads", 0, N_("Number of threads"), N_("Number of CPU threads for inference (0 = Auto)"), false)
+    add_integer("whisper-threads", 0, N_("Number of threads"), N_("Number of CPU threads for inference (0 = Auto, adjusted to keep up with real time)"), false)
+    add_integer("whisper-reserved-cores", 0, N_("Cores reserved for playback"), N_("Keep inference threads off the first N cores so decoding and output are not starved (Linux only, 0 = no pinning)"), false)
     add_integer("whisper-chunk-size", 10, N_("Chunk size (s)"), N_("Amount of audio to process at once in seconds"), false)
     add_integer("whisper-keep-size", 7, N_("Keep size (s)"), N_("Amount of audio to keep for context in seconds"), false)
+    add_integer("whisper-step-ms", 0, N_("Streaming step (ms)"), N_("Run inference every N ms over a sliding window and show partial results (0 = chunk mode)"), false)
+    add_integer("whisper-length-ms", 10000, N_("Streaming window (ms)"), N_("Length of the sliding window used in streaming mode"), false)
+    add_bool("whisper-vad", true, N_("Voice activity detection"), N_("Skip inference on silent audio and cut chunks at speech pauses"), false)
+    add_float("whisper-vad-threshold", 9.0, N_("VAD threshold (dB)"), N_("Energy above the noise floor needed to treat a 20 ms frame as speech"), false)
+    add_integer("whisper-max-backlog", 30, N_("Maximum backlog (s)"), N_("Audio waiting for transcription above which the overload policy applies"), false)
+    add_string("whisper-overload", "drop-oldest", N_("Overload policy"), N_("What to do when inference falls behind real time"), false)
+        change_string_list(ppsz_overload_values, ppsz_overload_texts)
+    add_string("whisper-fallback-model", "", N_("Fallback model"), N_("Smaller model to switch to with the 'degrade' overload policy"), false)
+    add_string("whisper-downmix", "itu", N_("Downmix"), N_("How to fold multichannel audio to mono before transcription"), false)
+        change_string_list(ppsz_downmix_values, ppsz_downmix_texts)
+    add_string("whisper-downmix-weights", "", N_("Custom downmix weights"), N_("Comma-separated weight per channel, in VLC channel order (used with the 'custom' downmix)"), false)
+    add_bool("whisper-fit-audio-ctx", false, N_("Fit encoder to the window"), N_("Run the encoder only over the audio in each window instead of a padded 30 s (faster, may lower accuracy)"), false)
+    add_bool("whisper-mel-frontend", false, N_("Incremental mel spectrogram"), N_("Compute each log-mel frame once and reuse it across overlapping windows instead of recomputing the whole window inside whisper (faster, but per-token times are estimated from segment times and text length, so overlap dedup may drop or repeat words)"), false)
+    add_bool("whisper-carry-context", true, N_("Carry context between windows"), N_("Pass the text already transcribed to the decoder as prompt, so a smaller keep size is enough"), false)
     add_bool("whisper-diarize", false, N_("Enable Diarization"), N_("Enable speaker turn detection (requires tinydiarize compatible model)"), false)
+
+    // Muestra en el vídeo lo que transcribe el filtro de audio
+    // (--sub-source=whisper_captions)
+    add_submodule ()
+    set_description(N_("Whisper captions (Sub source)"))
+    set_shortname(N_("Whisper captions"))
+    set_capability("sub source", 0)
+    set_category(CAT_VIDEO)
+    set_subcategory(SUBCAT_VIDEO_SUBPIC)
+    set_callbacks(OpenSub, CloseSub)
+    add_shortcut("whisper_captions")
 vlc_module_end ()
 
 static void WhisperWorker(filter_t *);
 
+// Hilo de audio: despierta al worker si espera y ya tiene datos suficientes
+static void SignalWorker(filter_sys_t *p_sys)
+{
+    // Empareja con el fence de WaitForSamples: o el worker ve los datos
+    // nuevos antes de dormir, o aquí vemos worker_idle y lo despertamos
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!p_sys->worker_idle.load(std::memory_order_relaxed))
+        return;
+    if (p_sys->pcm_ring.size() < p_sys->wake_samples.load(std::memory_order_relaxed))
+        return;
+
+    std::lock_guard<std::mutex> lock(p_sys->wake_mutex);
+    p_sys->wake_cv.notify_one();
+}
+
+// Worker: duerme hasta que termine la ventana oldest, haya n muestras en el
+// ring o se cierre el filtro. Al cerrar solo se espera a las ventanas en vuelo.
+static void WaitForWork(filter_sys_t *p_sys, size_t n, const window_job_t *oldest)
+{
+    std::unique_lock<std::mutex> lock(p_sys->wake_mutex);
+    p_sys->wake_samples.store(n, std::memory_order_relaxed);
+    p_sys->worker_idle.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    p_sys->wake_cv.wait(lock, [&] {
+        if (oldest && oldest->done.load(std::memory_order_acquire))
+            return true;
+        if (!p_sys->running)
+            return !oldest;
+        return p_sys->pcm_ring.size() >= n;
+    });
+    p_sys->worker_idle.store(false, std::memory_order_relaxed);
+}
+
+// Hilo del pool: la ventana terminó. Se notifica con el mutex tomado porque
+// en cuanto el worker la ve terminada puede cerrar el filtro.
+static void WindowDone(inference_job_t *job)
+{
+    window_job_t *w = (window_job_t *)job->opaque;
+    filter_sys_t *p_sys = w->p_sys;
+    std::lock_guard<std::mutex> lock(p_sys->wake_mutex);
+    w->done.store(true, std::memory_order_release);
+    p_sys->wake_cv.notify_one();
+}
+
+// Hilo del pool: etapas dentro de whisper_full. Antes del primer encoder va
+// el mel (si lo calcula whisper) y la detección de idioma; el primer
+// logits_filter_callback tras cada encoder llega en el primer paso del
+// decoder, después de procesar el prompt, así que el tramo medido es encoder
+// más prompt; lo que queda hasta el final es decodificación de la salida.
+static bool EncoderBegin(whisper_context *, whisper_state *, void *data)
+{
+    window_job_t *w = (window_job_t *)data;
+    w->t_encode = std::chrono::steady_clock::now();
+    if (w->pre_encode_ms < 0.0)
+        w->pre_encode_ms = std::chrono::duration<double, std::milli>(w->t_encode - w->job.started).count();
+    w->encoding = true;
+    return true;
+}
+
+static void EncoderEnd(whisper_context *, whisper_state *, const whisper_token_data *, int,
+                       float *, void *data)
+{
+    window_job_t *w = (window_job_t *)data;
+    if (!w->encoding)
+        return;
+    w->encoding = false;
+    w->encode_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - w->t_encode).count();
+}
+
+// whisper_full consulta esto entre pasos para abortar al cerrar
+static bool AbortInference(void *data)
+{
+    return !((filter_sys_t *)data)->running;
+}
+
+// Sub-bloque de conversión en el hilo de audio (muestras de entrada)
+static const size_t INGEST_BLOCK = 256;
+// Desfase tolerado antes de publicar una marca de tiempo nueva
+static const mtime_t TS_TOLERANCE = 2000;
+
+// Hilo de audio: fecha de la próxima muestra que se escribirá en el ring.
+// La salida k del resampler está centrada en la entrada k * in_rate / 16000
+// (su retardo no desplaza la señal), así que su fecha sale de la del bloque
+// restando la entrada que ya se había recibido.
+static void MarkTimestamp(filter_sys_t *p_sys, mtime_t pts)
+{
+    const size_t index = p_sys->pcm_ring.write_index();
+    const mtime_t date = pts
+        + (mtime_t)(p_sys->out_samples * CLOCK_FREQ / WHISPER_SAMPLE_RATE)
+        - (mtime_t)(p_sys->in_samples * CLOCK_FREQ / p_sys->in_rate);
+
+    const ts_anchor_t &last = p_sys->last_anchor;
+    if (last.date > VLC_TS_INVALID) {
+        const mtime_t expected = last.date + (mtime_t)((index - last.index) * CLOCK_FREQ / WHISPER_SAMPLE_RATE);
+        if (date > expected - TS_TOLERANCE && date < expected + TS_TOLERANCE)
+            return;
+    }
+
+    // Si la cola está llena se reintenta en el siguiente bloque
+    const ts_anchor_t anchor = { index, date };
+    if (p_sys->anchors.push(anchor))
+        p_sys->last_anchor = anchor;
+}
+
+// Worker: fecha de la muestra index del ring (VLC_TS_INVALID si el stream no
+// trae fechas). Olvida las marcas que quedan antes de la cola del ring.
+static mtime_t SampleDate(filter_sys_t *p_sys, size_t index)
+{
+    const size_t tail = p_sys->pcm_ring.read_index();
+    while (p_sys->anchors.size() > 0 && p_sys->anchors.peek(0).index <= tail) {
+        p_sys->base_anchor = p_sys->anchors.peek(0);
+        p_sys->anchors.pop();
+    }
+
+    ts_anchor_t a = p_sys->base_anchor;
+    const size_t n = p_sys->anchors.size();
+    for (size_t k = 0; k < n && p_sys->anchors.peek(k).index <= index; ++k)
+        a = p_sys->anchors.peek(k);
+
+    if (a.date <= VLC_TS_INVALID)
+        return VLC_TS_INVALID;
+    return a.date + (mtime_t)((int64_t)(index - a.index) * CLOCK_FREQ / WHISPER_SAMPLE_RATE);
+}
+
 static block_t *ProcessAudio(filter_t *p_filter, block_t *p_block)
 {
     filter_sys_t *p_sys = (filter_sys_t *)p_filter->p_sys;
     if (!p_sys || !p_block) return p_block;
 
-    if (p_filter->fmt_in.i_codec != VLC_CODEC_FL32)
-        return p_block;
-
-    const float *p_samples = (const float *)p_block->p_buffer;
+    const uint8_t *p_samples = p_block->p_buffer;
     const unsigned ch = p_filter->fmt_in.audio.i_channels;
 
     if (ch == 0 || p_block->i_nb_samples == 0)
         return p_block;
+    if (!p_sys->ingest.load(std::memory_order_relaxed))
+        return p_block;
 
-    // Mutex para evitar crash al leer desde el hilo
-    std::lock_guard<std::mutex> lock(p_sys->buffer_mutex);
+    if (p_block->i_pts > VLC_TS_INVALID)
+        MarkTimestamp(p_sys, p_block->i_pts);
 
-    // Límite de seguridad: 10 segundos de audio (basado en el rate de entrada)
-    // size_t max_samples = p_filter->fmt_in.audio.i_rate * 10;
-    // if (p_sys->pcm_buffer.size() + p_block->i_nb_samples > max_samples) {
-    //     size_t overflow = p_sys->pcm_buffer.size() + p_block->i_nb_samples - max_samples;
-    //     p_sys->pcm_buffer.erase(p_sys->pcm_buffer.begin(), 
-    //                             p_sys->pcm_buffer.begin() + overflow);
-    // }
+    const auto t_ingest = std::chrono::steady_clock::now();
 
-    // p_sys->pcm_buffer.reserve(max_samples);
+    // Sin mutex ni reservas: el hilo de audio convierte cada bloque a 16 kHz
+    // una sola vez y lo escribe en el ring. Si el worker va por detrás y el
+    // ring está lleno, se descarta lo que no cabe.
+    // Conversión de formato, downmix y resampling se hacen por sub-bloques
+    // que caben en caché, así el bloque de VLC se lee de memoria una sola vez.
+    float mono[INGEST_BLOCK];
+    size_t done = 0;
+    while (done < p_block->i_nb_samples) {
+        size_t n = p_block->i_nb_samples - done;
+        if (n > INGEST_BLOCK) n = INGEST_BLOCK;
 
-    for (size_t i = 0; i < p_block->i_nb_samples; ++i) {
-        p_sys->pcm_buffer.push_back(p_samples[i * ch]); // Canal 0
+        const void *src = p_samples + done * ch * p_sys->sample_bytes;
+        if (p_sys->convert) {
+            p_sys->convert(src, p_sys->ingest_f32.data(), n * ch);
+            src = p_sys->ingest_f32.data();
+        }
+        p_sys->downmix((const float *)src, mono, n, p_sys->downmix_w.data(), ch);
+        done += n;
+
+        const size_t n16 = p_sys->resampler.process(mono, n, p_sys->ingest16.data());
+        p_sys->in_samples += n;
+        p_sys->out_samples += n16;
+        const size_t written = p_sys->pcm_ring.write(p_sys->ingest16.data(), n16);
+        if (written < n16)
+            p_sys->dropped_overrun.fetch_add(n16 - written, std::memory_order_relaxed);
     }
+    p_sys->ingest_ns.fetch_add((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - t_ingest).count(), std::memory_order_relaxed);
 
-    // DEBUG: Should remove it
-    // static int log_counter = 0;
-    // if (++log_counter % 500 == 0) {
-    //     msg_Info(p_filter, "Buffer Whisper: %zu muestras acumuladas", p_sys->pcm_buffer.size());
-    // }
+    SignalWorker(p_sys);
 
     return p_block;
 }
 
+// Tiempo en pantalla de un subtítulo según su longitud
+static mtime_t CaptionDuration(const std::string &text)
+{
+    mtime_t d = (mtime_t)text.size() * 60000; // 60 ms por carácter
+    if (d < 1500000) d = 1500000;
+    if (d > 7000000) d = 7000000;
+    return d;
+}
+
+// start y stop son las fechas del audio transcrito; sin fechas se usa el
+// momento de publicación. stop se alarga hasta el tiempo de lectura.
+static void PublishCaption(filter_t *p_filter, std::string text, bool partial,
+                           mtime_t start, mtime_t stop)
+{
+    const size_t first = text.find_first_not_of(" \t\n");
+    if (first == std::string::npos)
+        return;
+    text.erase(0, first);
+
+    if (start <= VLC_TS_INVALID)
+        start = stop = mdate();
+    if (stop < start + CaptionDuration(text))
+        stop = start + CaptionDuration(text);
+
+    if (partial)
+        msg_Dbg(p_filter, "Whisper (parcial): %s", text.c_str());
+    else
+        msg_Info(p_filter, "Whisper [%+.2f s]: %s", (double)(start - mdate()) / CLOCK_FREQ, text.c_str());
+
+    filter_sys_t *p_sys = (filter_sys_t *)p_filter->p_sys;
+    p_sys->captions->publish(text.c_str(), start, stop, partial);
+}
+
+// Texto ya entregado: hasta qué muestra del ring llega y sus últimos tokens,
+// para reconocerlos cuando la siguiente ventana vuelve a transcribir el keep.
+// prompt es el historial que se pasa al decoder como contexto.
+struct transcript_t {
+    size_t committed_until = 0;
+    std::vector<whisper_token> recent;
+    std::vector<whisper_token> prompt;
+};
+
+struct window_token_t {
+    int segment;
+    whisper_token id;
+    size_t t0, t1, mid;     // índices del ring
+    const char *text;
+};
+
+// Tokens entregados que se recuerdan para alinear la ventana siguiente
+static const size_t RECENT_TOKENS = 32;
+// Margen alrededor del último corte en el que los tiempos de token no son fiables
+static const size_t OVERLAP_SLACK = WHISPER_SAMPLE_RATE / 2;
+
+// Publica lo nuevo de la ventana que empieza en window_start. Un final entrega
+// los tokens centrados antes de stable_end; lo posterior es el keep, que la
+// siguiente ventana volverá a transcribir con más contexto. Un parcial muestra
+// todo lo pendiente sin entregarlo.
+static void PublishWindow(filter_t *p_filter, whisper_state *state, transcript_t &tr,
+                          std::vector<window_token_t> &tokens,
+                          size_t window_start, size_t n_samples, size_t stable_end, bool partial)
+{
+    filter_sys_t *p_sys = (filter_sys_t *)p_filter->p_sys;
+    whisper_context *ctx = p_sys->ctx;
+    const whisper_token eot = whisper_token_eot(ctx);
+
+    tokens.clear();
+    const int n_segments = whisper_full_n_segments_from_state(state);
+    for (int i = 0; i < n_segments; ++i) {
+        const size_t seg_first = tokens.size();
+        bool timed = true;
+        const int n_tokens = whisper_full_n_tokens_from_state(state, i);
+        for (int j = 0; j < n_tokens; ++j) {
+            const whisper_token_data td = whisper_full_get_token_data_from_state(state, i, j);
+            if (td.id >= eot) continue; // marcas de tiempo y tokens especiales
+
+            window_token_t t;
+            t.segment = i;
+            t.id = td.id;
+            t.t0 = td.t0 > 0 ? std::min((size_t)td.t0 * (WHISPER_SAMPLE_RATE / 100), n_samples) : 0;
+            t.t1 = td.t1 > 0 ? std::min((size_t)td.t1 * (WHISPER_SAMPLE_RATE / 100), n_samples) : 0;
+            if (t.t1 < t.t0) t.t1 = t.t0;
+            timed &= td.t0 >= 0 && td.t1 >= td.t0;
+            t.text = whisper_full_get_token_text_from_state(ctx, state, i, j);
+            tokens.push_back(t);
+        }
+
+        // whisper solo da tiempos por token si calculó él el mel (los afina
+        // con la energía del PCM); con el mel propio van desactivados y se
+        // reparte el segmento según la longitud del texto
+        if (!timed) {
+            const size_t s0 = std::min((size_t)std::max<int64_t>(whisper_full_get_segment_t0_from_state(state, i), 0)
+                                       * (WHISPER_SAMPLE_RATE / 100), n_samples);
+            const size_t s1 = std::min((size_t)std::max<int64_t>(whisper_full_get_segment_t1_from_state(state, i), 0)
+                                       * (WHISPER_SAMPLE_RATE / 100), n_samples);
+            size_t chars = 0, done = 0;
+            for (size_t k = seg_first; k < tokens.size(); ++k)
+                chars += strlen(tokens[k].text) + 1;
+            for (size_t k = seg_first; k < tokens.size(); ++k) {
+                const size_t span = s1 > s0 ? s1 - s0 : 0;
+                tokens[k].t0 = s0 + span * done / chars;
+                done += strlen(tokens[k].text) + 1;
+                tokens[k].t1 = s0 + span * done / chars;
+            }
+        }
+
+        for (size_t k = seg_first; k < tokens.size(); ++k) {
+            window_token_t &t = tokens[k];
+            t.t0 += window_start;
+            t.t1 += window_start;
+            t.mid = t.t0 + (t.t1 - t.t0) / 2;
+        }
+    }
+
+    // Tras un salto (VAD, sobrecarga) no hay nada que alinear
+    if (tr.committed_until + OVERLAP_SLACK < window_start)
+        tr.recent.clear();
+
+    // Primer token nuevo: por tiempo, lo centrado después del último corte;
+    // pero cerca del corte los tiempos bailan entre ventanas y manda la
+    // coincidencia más larga con el final de lo ya entregado
+    size_t s = 0;
+    while (s < tokens.size() && tokens[s].mid + OVERLAP_SLACK < tr.committed_until) s++;
+    size_t zone = s, first = s;
+    while (zone < tokens.size() && tokens[zone].mid < tr.committed_until + OVERLAP_SLACK) zone++;
+    while (first < tokens.size() && tokens[first].mid < tr.committed_until) first++;
+
+    for (size_t k = std::min(tr.recent.size(), zone - s); k > 0; --k) {
+        size_t m = 0;
+        while (m < k && tokens[s + m].id == tr.recent[tr.recent.size() - k + m]) m++;
+        if (m == k) {
+            first = s + k;
+            break;
+        }
+    }
+
+    size_t end = partial ? tokens.size() : first;
+    while (end < tokens.size() && tokens[end].mid < stable_end) end++;
+
+    // Un subtítulo por segmento
+    for (size_t a = first; a < end; ) {
+        std::string text;
+        size_t b = a;
+        while (b < end && tokens[b].segment == tokens[a].segment)
+            text += tokens[b++].text;
+        PublishCaption(p_filter, text, partial, SampleDate(p_sys, tokens[a].t0), SampleDate(p_sys, tokens[b - 1].t1));
+        a = b;
+    }
+
+    if (partial) return;
+    for (size_t i = first; i < end; ++i) {
+        tr.recent.push_back(tokens[i].id);
+        tr.prompt.push_back(tokens[i].id);
+    }
+    if (tr.recent.size() > RECENT_TOKENS)
+        tr.recent.erase(tr.recent.begin(), tr.recent.end() - RECENT_TOKENS);
+    // whisper no usa más de medio contexto de texto como prompt
+    const size_t max_prompt = (size_t)whisper_n_text_ctx(ctx) / 2;
+    if (tr.prompt.size() > max_prompt)
+        tr.prompt.erase(tr.prompt.begin(), tr.prompt.end() - max_prompt);
+    if (stable_end > tr.committed_until)
+        tr.committed_until = stable_end;
+}
+
+// Solapamiento que se conserva al cerrar una línea en modo streaming
+static const int STREAM_KEEP_MS = 200;
+// Silencio final que cierra una línea en modo streaming con VAD
+static const int VAD_PAUSE_MS = 300;
+// Tope de whisper-max-inflight, además del tamaño del pool
+static const int MAX_INFLIGHT = 4;
+
+static void FreeStates(filter_sys_t *p_sys)
+{
+    for (window_job_t &w : p_sys->windows) {
+        if (w.state)
+            whisper_free_state(w.state);
+        w.state = nullptr;
+    }
+}
+
+// Un estado por ventana en vuelo sobre p_sys->ctx
+static bool InitStates(filter_sys_t *p_sys)
+{
+    for (window_job_t &w : p_sys->windows) {
+        w.state = whisper_init_state(p_sys->ctx);
+        if (!w.state) {
+            FreeStates(p_sys);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Mel incremental con el banco de filtros de path, el modelo de p_sys->ctx.
+// Las tramas cubren todo lo que el ring puede retener.
+static void SetupMel(filter_t *p_filter, const std::string &path)
+{
+    filter_sys_t *p_sys = (filter_sys_t *)p_filter->p_sys;
+    p_sys->use_mel = false;
+    if (!p_sys->mel_frontend)
+        return;
+
+    std::vector<float> filters;
+    unsigned n_mel;
+    if (!mel_read_filters(path.c_str(), filters, &n_mel) || (int)n_mel != whisper_model_n_mels(p_sys->ctx)
+     || !p_sys->mel.init(filters, n_mel, p_sys->pcm_ring.capacity() / MelFrontend::HOP + 2)) {
+        msg_Warn(p_filter, "Sin banco de filtros mel en %s, whisper calcula el espectrograma", path.c_str());
+        return;
+    }
+    p_sys->use_mel = true;
+}
+
+// Política "degrade": carga el modelo de respaldo en el hilo del worker.
+// Solo se llama sin ventanas en vuelo.
+static bool SwitchToFallbackModel(filter_t *p_filter)
+{
+    filter_sys_t *p_sys = (filter_sys_t *)p_filter->p_sys;
+    if (p_sys->fallback_model.empty()) {
+        msg_Warn(p_filter, "Sobrecarga: no hay whisper-fallback-model, se descarta audio");
+        return false;
+    }
+
+    msg_Warn(p_filter, "Sobrecarga: cambiando al modelo de respaldo %s", p_sys->fallback_model.c_str());
+    bool shared;
+    whisper_context *ctx = model_cache_acquire(p_sys->fallback_model.c_str(), p_sys->cparams, &shared);
+    // Los estados nuevos se crean antes de soltar el modelo actual
+    std::vector<whisper_state *> states;
+    for (size_t i = 0; ctx && i < p_sys->windows.size(); ++i) {
+        whisper_state *state = whisper_init_state(ctx);
+        if (!state) {
+            for (whisper_state *st : states)
+                whisper_free_state(st);
+            model_cache_release(ctx);
+            ctx = nullptr;
+            break;
+        }
+        states.push_back(state);
+    }
+    if (!ctx) {
+        msg_Err(p_filter, "Error cargando el modelo de respaldo, se descarta audio");
+        return false;
+    }
+
+    FreeStates(p_sys);
+    model_cache_release(p_sys->ctx);
+    p_sys->ctx = ctx;
+    for (size_t i = 0; i < states.size(); ++i)
+        p_sys->windows[i].state = states[i];
+    SetupMel(p_filter, p_sys->fallback_model);
+    return true;
+}
+
+// Autoajuste de hilos: la carga es el tiempo de inferencia de una ventana
+// frente al audio que llega mientras tanto (repartido entre las ventanas en
+// vuelo). Por encima de TUNE_HIGH no se llega a tiempo real y se añade un
+// hilo; por debajo de TUNE_LOW sobran y se devuelve uno a la reproducción.
+static const double TUNE_HIGH = 0.85;
+static const double TUNE_LOW = 0.45;
+static const unsigned TUNE_WINDOWS = 3;     // medidas entre ajustes
+
+struct thread_tuner_t {
+    double load = 0.0;      // media móvil
+    unsigned windows = 0;   // medidas con el número de hilos actual
+};
+
+static void TuneThreads(filter_t *p_filter, thread_tuner_t &tuner, const window_job_t *w, size_t budget_samples)
+{
+    filter_sys_t *p_sys = (filter_sys_t *)p_filter->p_sys;
+    int &n_threads = p_sys->wparams.n_threads;
+
+    // Solo cuentan las ventanas decodificadas con el número de hilos actual
+    if (w->job.params.n_threads != n_threads || budget_samples == 0)
+        return;
+
+    const double budget_ms = 1000.0 * budget_samples * p_sys->windows.size() / WHISPER_SAMPLE_RATE;
+    const double load = w->job.infer_ms / budget_ms;
+    tuner.load = tuner.windows ? 0.5 * tuner.load + 0.5 * load : load;
+    if (++tuner.windows < TUNE_WINDOWS)
+        return;
+
+    int n = n_threads;
+    if (tuner.load > TUNE_HIGH && n < p_sys->max_threads)
+        n++;
+    else if (tuner.load < TUNE_LOW && n > 1)
+        n--;
+    if (n == n_threads)
+        return;
+
+    msg_Dbg(p_filter, "Hilos de inferencia: %d -> %d (carga %.2f)", n_threads, n, tuner.load);
+    n_threads = n;
+    tuner.windows = 0;
+}
+
+// Métricas por ventana como variables del filtro (whisper-stat-*), para que
+// una interfaz o un script las lea con var_GetFloat, y un resumen en el log
+// cada STATS_PERIOD_S. La ingesta es el tiempo del hilo de audio desde la
+// ventana anterior. La detección de idioma, que whisper hace antes del
+// encoder, cuenta como mel si lo calcula whisper y como encoder si no. El
+// encoder incluye el prompt (ver EncoderBegin), que crece con
+// whisper-carry-context; whisper_get_timings no sirve con estados propios.
+// El RTF es el tiempo de inferencia frente a la duración de la ventana.
+enum {
+    STAT_WAIT, STAT_INGEST, STAT_MEL, STAT_ENCODE_PROMPT, STAT_DECODE, STAT_PUBLISH,
+    STAT_BUFFER, STAT_RTF, STAT_COUNT
+};
+
+static const struct {
+    const char *var;
+    const char *fmt;    // media/máximo en el resumen
+} stat_desc[STAT_COUNT] = {
+    { "whisper-stat-wait-ms",          "cola %.0f/%.0f ms" },
+    { "whisper-stat-ingest-ms",        "ingesta %.1f/%.1f ms" },
+    { "whisper-stat-mel-ms",           "mel %.1f/%.1f ms" },
+    { "whisper-stat-encode-prompt-ms", "encoder+prompt %.0f/%.0f ms" },
+    { "whisper-stat-decode-ms",        "decoder %.0f/%.0f ms" },
+    { "whisper-stat-publish-ms",       "publicación %.2f/%.2f ms" },
+    { "whisper-stat-buffer-s",         "buffer %.1f/%.1f s" },
+    { "whisper-stat-rtf",              "RTF %.2f/%.2f" },
+};
+static const char STAT_WINDOWS_VAR[] = "whisper-stat-windows";
+static const double STATS_PERIOD_S = 30.0;
+
+struct stage_stats_t {
+    int64_t windows = 0;            // desde el inicio
+    unsigned n = 0;                 // en el periodo actual
+    double sum[STAT_COUNT] = {};
+    double max[STAT_COUNT] = {};
+    uint64_t ingest_ns = 0;         // ingest_ns en la ventana anterior
+    std::chrono::steady_clock::time_point since = std::chrono::steady_clock::now();
+};
+
+static void CreateStatVars(filter_t *p_filter)
+{
+    for (const auto &d : stat_desc)
+        var_Create(p_filter, d.var, VLC_VAR_FLOAT);
+    var_Create(p_filter, STAT_WINDOWS_VAR, VLC_VAR_INTEGER);
+}
+
+static void DestroyStatVars(filter_t *p_filter)
+{
+    for (const auto &d : stat_desc)
+        var_Destroy(p_filter, d.var);
+    var_Destroy(p_filter, STAT_WINDOWS_VAR);
+}
+
+static void LogStats(filter_t *p_filter, stage_stats_t &st)
+{
+    if (st.n == 0)
+        return;
+    std::string line;
+    for (int i = 0; i < STAT_COUNT; ++i) {
+        char part[64];
+        snprintf(part, sizeof(part), stat_desc[i].fmt, st.sum[i] / st.n, st.max[i]);
+        line += i ? ", " : "";
+        line += part;
+    }
+    msg_Info(p_filter, "Etapas (media/máx. de %u ventanas): %s", st.n, line.c_str());
+
+    st.n = 0;
+    std::fill(st.sum, st.sum + STAT_COUNT, 0.0);
+    std::fill(st.max, st.max + STAT_COUNT, 0.0);
+    st.since = std::chrono::steady_clock::now();
+}
+
+static void RecordStats(filter_t *p_filter, stage_stats_t &st, const window_job_t *w, double publish_ms)
+{
+    filter_sys_t *p_sys = (filter_sys_t *)p_filter->p_sys;
+    const uint64_t ingest_ns = p_sys->ingest_ns.load(std::memory_order_relaxed);
+
+    // Sin encoder (ventana demasiado corta) todo cuenta como antes de él
+    const double infer = w->job.infer_ms;
+    const double pre = w->pre_encode_ms < 0.0 ? infer : w->pre_encode_ms;
+    const bool own_mel = w->job.samples == NULL;
+
+    double v[STAT_COUNT];
+    v[STAT_WAIT] = w->job.wait_ms;
+    v[STAT_INGEST] = (double)(ingest_ns - st.ingest_ns) / 1e6;
+    v[STAT_MEL] = own_mel ? w->mel_ms : pre;
+    v[STAT_ENCODE_PROMPT] = w->encode_ms + (own_mel ? pre : 0.0);
+    v[STAT_DECODE] = std::max(0.0, infer - pre - w->encode_ms);
+    v[STAT_PUBLISH] = publish_ms;
+    v[STAT_BUFFER] = (double)w->depth / WHISPER_SAMPLE_RATE;
+    v[STAT_RTF] = infer * WHISPER_SAMPLE_RATE / (1000.0 * w->n);
+    st.ingest_ns = ingest_ns;
+
+    for (int i = 0; i < STAT_COUNT; ++i) {
+        var_SetFloat(p_filter, stat_desc[i].var, (float)v[i]);
+        st.sum[i] += v[i];
+        st.max[i] = std::max(st.max[i], v[i]);
+    }
+    var_SetInteger(p_filter, STAT_WINDOWS_VAR, ++st.windows);
+    st.n++;
+
+    if (std::chrono::duration<double>(std::chrono::steady_clock::now() - st.since).count() >= STATS_PERIOD_S)
+        LogStats(p_filter, st);
+}
+
+// Encoder ajustado a la ventana: whisper rellena todo a 30 s (1500 tramas de
+// encoder, 50 por segundo). Con audio_ctx solo se codifica el audio real más
+// un margen, redondeado a cubos para que haya pocas longitudes distintas, y
+// con un mínimo por debajo del cual la calidad cae.
+static const int AUDIO_CTX_PER_S = 50;
+static const int AUDIO_CTX_MARGIN = 50;     // 1 s
+static const int AUDIO_CTX_BUCKET = 64;
+static const int AUDIO_CTX_MIN = 256;
+
+static int AudioCtxFor(whisper_context *ctx, size_t n_samples)
+{
+    int n = (int)((n_samples * AUDIO_CTX_PER_S + WHISPER_SAMPLE_RATE - 1) / WHISPER_SAMPLE_RATE);
+    n = (n + AUDIO_CTX_MARGIN + AUDIO_CTX_BUCKET - 1) / AUDIO_CTX_BUCKET * AUDIO_CTX_BUCKET;
+    if (n < AUDIO_CTX_MIN) n = AUDIO_CTX_MIN;
+    // A partir del máximo del modelo no hay nada que ahorrar
+    return n < whisper_n_audio_ctx(ctx) ? n : 0;
+}
+
+// Worker: carga el modelo (compartido entre filtros) y crea los estados propios
+static bool LoadModel(filter_t *p_filter)
+{
+    filter_sys_t *p_sys = (filter_sys_t *)p_filter->p_sys;
+    const auto t_start = std::chrono::steady_clock::now();
+
+    bool shared;
+    p_sys->ctx = model_cache_acquire(p_sys->model_path.c_str(), p_sys->cparams, &shared);
+    if (!p_sys->ctx) {
+        msg_Err(p_filter, "Error cargando Whisper");
+        return false;
+    }
+
+    if (!InitStates(p_sys)) {
+        msg_Err(p_filter, "Error creando el estado de Whisper");
+        model_cache_release(p_sys->ctx);
+        p_sys->ctx = nullptr;
+        return false;
+    }
+    SetupMel(p_filter, p_sys->model_path);
+
+    msg_Info(p_filter, "Modelo %s %s en %.2f s, %.1f s de audio en espera",
+             p_sys->model_path.c_str(), shared ? "compartido" : "cargado",
+             std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count(),
+             (double)p_sys->pcm_ring.size() / WHISPER_SAMPLE_RATE);
+    return true;
+}
+
 static void WhisperWorker(filter_t *p_filter)
 {
     filter_sys_t *p_sys = (filter_sys_t *)p_filter->p_sys;
-    const size_t CHUNK_SAMPLES = p_filter->fmt_in.audio.i_rate * p_sys->chunk_size;
-    const size_t KEEP_SAMPLES = p_filter->fmt_in.audio.i_rate * p_sys->keep_size;
+
+    if (!LoadModel(p_filter)) {
+        msg_Warn(p_filter, "Sin modelo: el filtro deja pasar el audio sin transcribir");
+        p_sys->ingest.store(false, std::memory_order_relaxed);
+        return;
+    }
+
+    const bool streaming = p_sys->step_ms > 0;
+
+    // Modo chunk: ventanas fijas de chunk_size con keep_size de solapamiento.
+    // Modo streaming: cada step_ms se transcribe la ventana acumulada (hasta
+    // length_ms) como resultado parcial; cada length/step - 1 pasos, o cuando
+    // la ventana se llena, la línea se da por final y se conserva STREAM_KEEP_MS.
+    const size_t STEP_SAMPLES = streaming
+        ? (size_t)WHISPER_SAMPLE_RATE * p_sys->step_ms / 1000
+        : (size_t)WHISPER_SAMPLE_RATE * (p_sys->chunk_size - p_sys->keep_size);
+    const size_t KEEP_SAMPLES = streaming
+        ? (size_t)WHISPER_SAMPLE_RATE * STREAM_KEEP_MS / 1000
+        : (size_t)WHISPER_SAMPLE_RATE * p_sys->keep_size;
+    const size_t WINDOW_SAMPLES = streaming
+        ? (size_t)WHISPER_SAMPLE_RATE * p_sys->length_ms / 1000 + KEEP_SAMPLES
+        : (size_t)WHISPER_SAMPLE_RATE * p_sys->chunk_size;
+    const int n_new_line = streaming && p_sys->length_ms / p_sys->step_ms > 1
+        ? p_sys->length_ms / p_sys->step_ms - 1 : 1;
 
     msg_Info(p_filter, "Hilo de Whisper iniciado.");
+    if (p_sys->fit_audio_ctx)
+        msg_Info(p_filter, "Encoder ajustado: audio_ctx %d de %d para ventanas de %.1f s",
+                 AudioCtxFor(p_sys->ctx, WINDOW_SAMPLES), whisper_n_audio_ctx(p_sys->ctx),
+                 (double)WINDOW_SAMPLES / WHISPER_SAMPLE_RATE);
 
-    while (p_sys->running) {
-        std::vector<float> samples;
+    // El ring ya está a 16 kHz y las ventanas se leen en el sitio con
+    // view_at(). cursor es el inicio de la próxima ventana; la cola del ring
+    // se queda en el inicio de la ventana en vuelo más antigua, así que el
+    // audio retenido entre pasos (keep) y el que aún se decodifica siguen en
+    // memoria hasta que se publica su resultado.
+    size_t cursor = p_sys->pcm_ring.read_index();
+    size_t held = 0;
+    int n_iter = 0;
 
-        {
-            std::lock_guard<std::mutex> lock(p_sys->buffer_mutex);
-            if (p_sys->pcm_buffer.size() >= CHUNK_SAMPLES) {
-                samples.assign(p_sys->pcm_buffer.begin(), p_sys->pcm_buffer.end());
-                p_sys->pcm_buffer.erase(p_sys->pcm_buffer.begin(), p_sys->pcm_buffer.end() - KEEP_SAMPLES);
+    std::deque<window_job_t *> in_flight;   // en orden de envío
+    std::vector<window_job_t *> idle;
+    for (window_job_t &w : p_sys->windows)
+        idle.push_back(&w);
+
+    Vad vad;
+    vad.init(p_sys->vad_threshold, WINDOW_SAMPLES);
+
+    // Estadísticas del VAD: audio omitido y coste medio de inferencia
+    uint64_t vad_skipped_samples = 0, infer_samples = 0;
+    unsigned vad_skipped = 0, n_infer = 0;
+    double infer_ms = 0.0;
+
+    bool degraded = false;
+
+    transcript_t transcript;
+    std::vector<window_token_t> tokens;
+
+    InferencePool &pool = InferencePool::instance();
+    if (!pool.acquire(p_sys->pool_size, p_sys->reserved_cpus))
+        msg_Warn(p_filter, "No se pudieron fijar los hilos de inferencia fuera de %u CPU reservadas",
+                 p_sys->reserved_cpus);
+
+    thread_tuner_t tuner;
+    stage_stats_t stats;
+
+    for (;;) {
+        // Resultados en orden de envío, aunque el pool los termine en otro
+        while (!in_flight.empty() && in_flight.front()->done.load(std::memory_order_acquire)) {
+            window_job_t *w = in_flight.front();
+            in_flight.pop_front();
+            if (w->job.ret == 0) {
+                infer_ms += w->job.infer_ms;
+                infer_samples += w->n;
+                n_infer++;
+                if (p_sys->auto_threads)
+                    TuneThreads(p_filter, tuner, w, streaming ? STEP_SAMPLES : w->release);
+                // Los tiempos de token van en centésimas desde el inicio de
+                // la ventana (incluido el keep)
+                const auto t_publish = std::chrono::steady_clock::now();
+                PublishWindow(p_filter, w->state, transcript, tokens, w->start, w->n,
+                              w->start + w->release, !w->is_final);
+                RecordStats(p_filter, stats, w,
+                            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t_publish).count());
             }
+            idle.push_back(w);
         }
+        const size_t tail = in_flight.empty() ? cursor : in_flight.front()->start;
+        p_sys->pcm_ring.consume(tail - p_sys->pcm_ring.read_index());
 
-        if (samples.empty()) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (!p_sys->running) {
+            if (in_flight.empty())
+                break;
+            WaitForWork(p_sys, SIZE_MAX, in_flight.front());
             continue;
         }
 
-        msg_Info(p_filter, "Buffer OK (bloque de %zu), resampleando e iniciando inferencia...", samples.size());
-
-        whisper_full_params wp = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
-        wp.language = p_sys->language.c_str();
-        wp.translate = p_sys->translate;
-        wp.n_threads = p_sys->n_threads;
-        wp.tdrz_enable = p_sys->diarize;
+        // Hace falta un hueco libre y audio suficiente a partir de cursor
+        const size_t need = cursor - tail + (streaming ? held + STEP_SAMPLES : WINDOW_SAMPLES);
+        if (idle.empty() || p_sys->pcm_ring.size() < need) {
+            WaitForWork(p_sys, idle.empty() ? SIZE_MAX : need,
+                        in_flight.empty() ? NULL : in_flight.front());
+            continue;
+        }
 
-        // Resampling a 16kHz (Requerido por Whisper)
-        std::vector<float> samples16;
-        const double scale = 16000.0 / p_filter->fmt_in.audio.i_rate;
-        const size_t n_out = (size_t)(samples.size() * scale);
-        samples16.reserve(n_out);
+        // Sobrecarga: la inferencia va más lenta que el tiempo real. El
+        // backlog es el audio que aún no ha entrado en ninguna ventana.
+        const size_t backlog = tail + p_sys->pcm_ring.size() - cursor;
+        if (backlog > p_sys->max_backlog) {
+            size_t drop = 0;
+            if (p_sys->overload == OVERLOAD_SKIP_TO_LIVE)
+                drop = backlog - (streaming ? STEP_SAMPLES : WINDOW_SAMPLES);
+            else if (p_sys->overload == OVERLOAD_DROP_OLDEST || degraded)
+                drop = backlog - p_sys->max_backlog;
+            else if (!in_flight.empty()) {
+                // El cambio de modelo espera a que no quede nada en vuelo
+                WaitForWork(p_sys, SIZE_MAX, in_flight.front());
+                continue;
+            }
+            else {
+                // El modelo de respaldo tampoco debe empezar por encima del
+                // límite: se recorta como drop-oldest, con cambio o sin él,
+                // contando el audio que llegó mientras se cargaba
+                if (SwitchToFallbackModel(p_filter))
+                    transcript.prompt.clear(); // el vocabulario puede ser otro
+                drop = tail + p_sys->pcm_ring.size() - cursor - p_sys->max_backlog;
+            }
+            degraded |= p_sys->overload == OVERLOAD_DEGRADE;
 
-        for (size_t i = 0; i < n_out; i++) {
-            size_t src_idx = (size_t)(i / scale);
-            if (src_idx < samples.size()) {
-                samples16.push_back(samples[src_idx]);
+            // Las ventanas empiezan siempre en una trama del mel
+            drop -= drop % MelFrontend::HOP;
+            if (drop > 0) {
+                cursor += drop;
+                const uint64_t total = p_sys->dropped_overload.fetch_add(drop, std::memory_order_relaxed) + drop;
+                held = 0;
+                n_iter = 0;
+                msg_Warn(p_filter, "Sobrecarga: descartados %.1f s de audio (total %.1f s)",
+                         (double)drop / WHISPER_SAMPLE_RATE, (double)total / WHISPER_SAMPLE_RATE);
+                continue;
             }
         }
-        
-        if (whisper_full(p_sys->ctx, wp, samples16.data(), (int)samples16.size()) == 0) {
-            const int n = whisper_full_n_segments(p_sys->ctx);
-            std::string result;
-            for (int i = 0; i < n; ++i) {
-                const char* text = whisper_full_get_segment_text(p_sys->ctx, i);
-                if (text) result += text;
+
+        size_t n_samples = WINDOW_SAMPLES;
+        const float *samples = p_sys->pcm_ring.view_at(cursor, &n_samples);
+        bool is_final = !streaming || ++n_iter % n_new_line == 0 || n_samples >= WINDOW_SAMPLES;
+        bool speech = true;
+
+        if (p_sys->vad) {
+            // Modo chunk: en vez de cortar a ciegas en chunk_size, se corta en
+            // la pausa más silenciosa del último cuarto, respetando el keep
+            if (!streaming) {
+                size_t from = KEEP_SAMPLES + WHISPER_SAMPLE_RATE;
+                if (from < WINDOW_SAMPLES - WINDOW_SAMPLES / 4)
+                    from = WINDOW_SAMPLES - WINDOW_SAMPLES / 4;
+                const size_t cut = vad.find_pause(samples, from, n_samples);
+                if (cut) n_samples = cut;
             }
 
-            if (!result.empty()) {
-                msg_Info(p_filter, "Whisper: %s", result.c_str());
-                // std::lock_guard<std::mutex> lock(g_state.lock);
-                // g_state.current_text = result;
-                // g_state.last_update = mdate();
+            speech = vad.has_speech(samples, n_samples);
+            // Modo streaming: la línea se cierra en la primera pausa, y el
+            // silencio acumulado se descarta sin transcribir
+            if (!speech || (streaming && vad.ends_in_pause(samples, n_samples, VAD_PAUSE_MS)))
+                is_final = true;
+        }
+
+        // Lo que la ventana deja atrás para la siguiente; se libera del ring
+        // cuando se publica su resultado
+        size_t release = 0;
+        if (is_final) {
+            release = n_samples > KEEP_SAMPLES ? n_samples - KEEP_SAMPLES : 0;
+            release -= release % MelFrontend::HOP;
+            held = n_samples - release;
+            n_iter = 0;
+        } else {
+            held = n_samples;
+        }
+
+        if (!speech) {
+            vad_skipped++;
+            vad_skipped_samples += n_samples;
+            msg_Dbg(p_filter, "VAD: bloque de %zu sin voz, se omite la inferencia", n_samples);
+            cursor += release;
+            continue;
+        }
+
+        msg_Dbg(p_filter, "Buffer OK (bloque de %zu), iniciando inferencia...", n_samples);
+
+        window_job_t *w = idle.back();
+        idle.pop_back();
+        w->start = cursor;
+        w->n = n_samples;
+        w->release = release;
+        w->is_final = is_final;
+        w->done.store(false, std::memory_order_relaxed);
+        w->depth = backlog;
+        w->mel_ms = 0.0;
+        w->pre_encode_ms = -1.0;
+        w->encode_ms = 0.0;
+        w->encoding = false;
+
+        w->job.params = p_sys->wparams;
+        if (p_sys->carry_context) {
+            w->prompt = transcript.prompt;
+            w->job.params.prompt_tokens = w->prompt.empty() ? NULL : w->prompt.data();
+            w->job.params.prompt_n_tokens = (int)w->prompt.size();
+        }
+        if (p_sys->fit_audio_ctx)
+            w->job.params.audio_ctx = AudioCtxFor(p_sys->ctx, n_samples);
+        w->job.params.encoder_begin_callback = EncoderBegin;
+        w->job.params.encoder_begin_callback_user_data = w;
+        w->job.params.logits_filter_callback = EncoderEnd;
+        w->job.params.logits_filter_callback_user_data = w;
+        w->job.ctx = p_sys->ctx;
+        w->job.state = w->state;
+        w->job.samples = samples;
+        w->job.n_samples = (int)n_samples;
+
+        // Con el mel ya calculado el pool solo ejecuta encoder y decoder; el
+        // estado está libre, así que se le puede cargar el mel desde aquí.
+        // duration_ms acota la decodificación al audio real sin el relleno.
+        if (p_sys->use_mel) {
+            const auto t_mel = std::chrono::steady_clock::now();
+            const size_t from = std::max(p_sys->mel.pending_from(), p_sys->pcm_ring.read_index());
+            size_t avail = SIZE_MAX;
+            const float *s = p_sys->pcm_ring.view_at(from, &avail);
+            p_sys->mel.update(s, from, avail);
+
+            const int n_len = p_sys->mel.window(cursor, n_samples, p_sys->mel_window);
+            if (n_len > 0 && whisper_set_mel_with_state(p_sys->ctx, w->state, p_sys->mel_window.data(),
+                                                        n_len, (int)p_sys->mel.n_mel()) == 0) {
+                w->job.samples = NULL;
+                w->job.n_samples = 0;
+                w->job.params.duration_ms = (int)(n_samples * 1000 / WHISPER_SAMPLE_RATE);
+                // Sin PCM whisper no puede afinar los tiempos por token (y
+                // el estado podría conservar la energía de otra ventana)
+                w->job.params.token_timestamps = false;
             }
+            w->mel_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t_mel).count();
         }
+
+        in_flight.push_back(w);
+        cursor += release;
+        pool.submit(&w->job);
+    }
+
+    pool.release();
+
+    LogStats(p_filter, stats);
+
+    if (p_sys->vad) {
+        // Ahorro estimado con el coste medio por segundo de audio transcrito
+        const double skipped_s = (double)vad_skipped_samples / WHISPER_SAMPLE_RATE;
+        const double ms_per_s = infer_samples ? infer_ms * WHISPER_SAMPLE_RATE / infer_samples : 0.0;
+        msg_Info(p_filter, "VAD: %u de %u bloques omitidos (%.1f s de audio), ~%.1f s de inferencia ahorrados",
+                 vad_skipped, vad_skipped + n_infer, skipped_s, skipped_s * ms_per_s / 1000.0);
     }
 
+    msg_Info(p_filter, "Audio descartado: %.1f s por sobrecarga, %.1f s con el ring lleno",
+             (double)p_sys->dropped_overload.load() / WHISPER_SAMPLE_RATE,
+             (double)p_sys->dropped_overrun.load() / WHISPER_SAMPLE_RATE);
+
     msg_Info(p_filter, "Hilo de Whisper terminando.");
 }
 
+// Orden de los canales entrelazados en VLC
+static const uint32_t pi_chan_order[] = {
+    AOUT_CHAN_LEFT, AOUT_CHAN_RIGHT, AOUT_CHAN_MIDDLELEFT, AOUT_CHAN_MIDDLERIGHT,
+    AOUT_CHAN_REARLEFT, AOUT_CHAN_REARRIGHT, AOUT_CHAN_REARCENTER,
+    AOUT_CHAN_CENTER, AOUT_CHAN_LFE
+};
+
+// "w0,w1,..." con exactamente un peso por canal
+static bool ParseDownmixWeights(const char *str, std::vector<float> &w)
+{
+    const char *p = str;
+    for (size_t i = 0; i < w.size(); ++i) {
+        if (!p || !*p) return false;
+        char *end;
+        w[i] = strtof(p, &end);
+        if (end == p) return false;
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return p && !*p;
+}
+
+// Pesos "center" o "itu" a partir de la posición de cada canal.
+// Devuelve false si la disposición es desconocida.
+static bool LayoutDownmixWeights(const std::vector<uint32_t> &pos, bool itu, std::vector<float> &w)
+{
+    bool has_center = false, has_front = false;
+    for (size_t i = 0; i < pos.size(); ++i) {
+        switch (pos[i]) {
+            case AOUT_CHAN_CENTER:
+                w[i] = itu ? 0.7071f : 1.0f;
+                has_center = true;
+                break;
+            case AOUT_CHAN_LEFT: case AOUT_CHAN_RIGHT:
+                w[i] = itu ? 0.5f : 0.0f;
+                has_front = true;
+                break;
+            case AOUT_CHAN_MIDDLELEFT: case AOUT_CHAN_MIDDLERIGHT:
+            case AOUT_CHAN_REARLEFT: case AOUT_CHAN_REARRIGHT:
+            case AOUT_CHAN_REARCENTER:
+                w[i] = itu ? 0.3536f : 0.0f;
+                break;
+            default: // LFE
+                w[i] = 0.0f;
+                break;
+        }
+    }
+    // "center" sin canal central: media de izquierda y derecha
+    if (!itu && !has_center && has_front) {
+        for (size_t i = 0; i < pos.size(); ++i)
+            if (pos[i] == AOUT_CHAN_LEFT || pos[i] == AOUT_CHAN_RIGHT)
+                w[i] = 0.5f;
+    }
+    return has_center || has_front;
+}
+
+// Calcula un peso por canal según la estrategia de downmix
+static void SetupDownmix(filter_t *p_filter, filter_sys_t *p_sys,
+                         const char *mode, const char *custom)
+{
+    const unsigned ch = p_filter->fmt_in.audio.i_channels;
+    const uint32_t mask = p_filter->fmt_in.audio.i_physical_channels;
+
+    // Canal físico de cada posición; todo 0 si la máscara no cuadra con ch
+    std::vector<uint32_t> pos(ch, 0);
+    unsigned n_mask = 0;
+    for (uint32_t c : pi_chan_order)
+        if (mask & c) n_mask++;
+    if (n_mask == ch) {
+        unsigned i = 0;
+        for (uint32_t c : pi_chan_order)
+            if (mask & c) pos[i++] = c;
+    }
+
+    std::vector<float> &w = p_sys->downmix_w;
+    w.assign(ch, 0.0f);
+    bool ok = false;
+
+    if (!strcmp(mode, "custom")) {
+        ok = ParseDownmixWeights(custom, w);
+        if (!ok) {
+            msg_Warn(p_filter, "Pesos de downmix inválidos ('%s') para %u canales, usando ITU", custom ? custom : "", ch);
+            mode = "itu";
+        }
+    }
+    if (!ok && (ch == 1 || !strcmp(mode, "first"))) {
+        w.assign(ch, 0.0f);
+        w[0] = 1.0f;
+        ok = true;
+    }
+    if (!ok && (!strcmp(mode, "center") || !strcmp(mode, "itu"))) {
+        ok = LayoutDownmixWeights(pos, !strcmp(mode, "itu"), w);
+        if (!ok)
+            mode = "mean";
+    }
+    if (!ok) {
+        unsigned n = 0;
+        for (unsigned i = 0; i < ch; ++i)
+            if (pos[i] != AOUT_CHAN_LFE) n++;
+        for (unsigned i = 0; i < ch; ++i)
+            w[i] = (pos[i] != AOUT_CHAN_LFE) ? 1.0f / n : 0.0f;
+    }
+
+    p_sys->downmix = dsp_downmix(ch);
+
+    std::string desc;
+    for (unsigned i = 0; i < ch; ++i) {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%s%.3f", i ? " " : "", w[i]);
+        desc += buf;
+    }
+    msg_Info(p_filter, "Downmix %s: %u canales, pesos [%s]", mode, ch, desc.c_str());
+}
+
 static int OpenAudio(vlc_object_t *obj)
 {
     filter_t *p_filter = (filter_t *)obj;
@@ -193,6 +1256,44 @@ static int OpenAudio(vlc_object_t *obj)
     msg_Info(p_filter, "Formato de entrada: %d Hz, %d canales", 
          p_filter->fmt_in.audio.i_rate, p_filter->fmt_in.audio.i_channels);
 
+    if (p_filter->fmt_in.audio.i_rate == 0 || p_filter->fmt_in.audio.i_channels == 0) {
+        msg_Err(p_filter, "Formato de entrada inválido");
+        delete p_sys;
+        p_filter->p_sys = NULL;
+        return VLC_EGENERIC;
+    }
+
+    // Formatos de muestra aceptados; la escala a [-1, 1] de los enteros
+    // se aplica en los pesos del downmix
+    float scale = 1.0f;
+    switch (p_filter->fmt_in.i_codec) {
+        case VLC_CODEC_FL32:
+            p_sys->convert = NULL;
+            p_sys->sample_bytes = 4;
+            break;
+        case VLC_CODEC_S16N:
+            p_sys->convert = dsp_convert(SAMPLE_S16);
+            p_sys->sample_bytes = 2;
+            scale = 1.0f / 32768.0f;
+            break;
+        case VLC_CODEC_S32N:
+            p_sys->convert = dsp_convert(SAMPLE_S32);
+            p_sys->sample_bytes = 4;
+            scale = 1.0f / 2147483648.0f;
+            break;
+        case VLC_CODEC_FL64:
+            p_sys->convert = dsp_convert(SAMPLE_F64);
+            p_sys->sample_bytes = 8;
+            break;
+        default:
+            msg_Err(p_filter, "Formato de muestra no soportado: %4.4s", (const char *)&p_filter->fmt_in.i_codec);
+            delete p_sys;
+            p_filter->p_sys = NULL;
+            return VLC_EGENERIC;
+    }
+    if (p_sys->convert)
+        p_sys->ingest_f32.resize(INGEST_BLOCK * p_filter->fmt_in.audio.i_channels);
+
     // if (p_filter->fmt_in.audio.i_rate != 16000) {
     //     msg_Err(p_filter, "Whisper requiere 16000Hz, pero el stream es de %dHz", p_filter->fmt_in.audio.i_rate);
     //     delete p_sys;
@@ -214,15 +1315,57 @@ static int OpenAudio(vlc_object_t *obj)
     int max_hw = std::thread::hardware_concurrency();
     if (max_hw < 1) max_hw = 1;
 
+    // Núcleos reservados para la reproducción; al menos uno para la inferencia
+    int reserved = var_InheritInteger(p_filter, "whisper-reserved-cores");
+    if (reserved < 0) reserved = 0;
+    if (reserved >= max_hw) reserved = max_hw - 1;
+#ifndef __linux__
+    if (reserved > 0)
+        msg_Warn(p_filter, "whisper-reserved-cores solo está disponible en Linux");
+    reserved = 0;
+#endif
+    p_sys->reserved_cpus = (unsigned)reserved;
+    const int avail_hw = max_hw - reserved;
+
     p_sys->n_threads = var_InheritInteger(p_filter, "whisper-threads");
+    p_sys->auto_threads = p_sys->n_threads <= 0;
     if (p_sys->n_threads <= 0) {
-        p_sys->n_threads = (max_hw > 4) ? 4 : max_hw;
-    } else if (p_sys->n_threads > max_hw) {
-        msg_Warn(p_filter, "Hilos configurados (%d) exceden el hardware. Limitando a %d", p_sys->n_threads, max_hw);
-        p_sys->n_threads = max_hw;
+        // Punto de partida; el worker lo ajusta según la carga medida
+        p_sys->n_threads = (avail_hw > 4) ? 4 : avail_hw;
+    } else if (p_sys->n_threads > avail_hw) {
+        msg_Warn(p_filter, "Hilos configurados (%d) exceden el hardware. Limitando a %d", p_sys->n_threads, avail_hw);
+        p_sys->n_threads = avail_hw;
+    }
+
+    // Pool global: por defecto tantas ventanas a la vez como caben en los
+    // núcleos con n_threads cada una
+    int pool_size = var_InheritInteger(p_filter, "whisper-pool-size");
+    if (pool_size <= 0)
+        pool_size = avail_hw / p_sys->n_threads > 1 ? avail_hw / p_sys->n_threads : 1;
+    p_sys->pool_size = (unsigned)pool_size;
+
+    // Cada ventana en vuelo tiene su propio whisper_state (cientos de MB en
+    // los modelos grandes) y agranda el ring; más de las que admite el pool
+    // no se ejecutarían a la vez
+    int max_inflight = var_InheritInteger(p_filter, "whisper-max-inflight");
+    if (max_inflight < 1) max_inflight = 1;
+    const int max_allowed = pool_size < MAX_INFLIGHT ? pool_size : MAX_INFLIGHT;
+    if (max_inflight > max_allowed) {
+        msg_Warn(p_filter, "Ventanas en vuelo (%d) exceden el pool o el máximo (%d). Limitando a %d",
+                 max_inflight, MAX_INFLIGHT, max_allowed);
+        max_inflight = max_allowed;
+    }
+    // Con varias ventanas en vuelo el autoajuste reparte los núcleos entre ellas
+    p_sys->max_threads = avail_hw / max_inflight > 1 ? avail_hw / max_inflight : 1;
+    p_sys->windows = std::vector<window_job_t>(max_inflight);
+    for (window_job_t &w : p_sys->windows) {
+        w.p_sys = p_sys;
+        w.job.done = WindowDone;
+        w.job.opaque = &w;
     }
 
     p_sys->chunk_size = var_InheritInteger(p_filter, "whisper-chunk-size");
+    if (p_sys->chunk_size < 1) p_sys->chunk_size = 1;
     p_sys->keep_size = var_InheritInteger(p_filter, "whisper-keep-size");
     if (p_sys->keep_size >= p_sys->chunk_size) {
         msg_Warn(p_filter, "Keep size (%d) >= Chunk size (%d). Ajustando keep a la mitad del chunk", p_sys->keep_size, p_sys->chunk_size);
@@ -230,7 +1373,63 @@ static int OpenAudio(vlc_object_t *obj)
     }
     if (p_sys->keep_size < 0) p_sys->keep_size = 0;
 
+    p_sys->step_ms = var_InheritInteger(p_filter, "whisper-step-ms");
+    p_sys->length_ms = var_InheritInteger(p_filter, "whisper-length-ms");
+    if (p_sys->step_ms < 0) p_sys->step_ms = 0;
+    if (p_sys->step_ms > 0 && p_sys->length_ms < p_sys->step_ms) {
+        msg_Warn(p_filter, "Ventana de streaming (%d ms) < paso (%d ms). Ajustando ventana al paso", p_sys->length_ms, p_sys->step_ms);
+        p_sys->length_ms = p_sys->step_ms;
+    }
+
+    char *psz_downmix = var_InheritString(p_filter, "whisper-downmix");
+    char *psz_weights = var_InheritString(p_filter, "whisper-downmix-weights");
+    SetupDownmix(p_filter, p_sys, psz_downmix ? psz_downmix : "itu", psz_weights);
+    for (float &w : p_sys->downmix_w)
+        w *= scale;
+    // free(psz_downmix); free(psz_weights); Cross-Heap Allocation Issue caused by mismatched compilers (msvc vs gcc)
+
+    p_sys->vad = var_InheritBool(p_filter, "whisper-vad");
+    p_sys->vad_threshold = var_InheritFloat(p_filter, "whisper-vad-threshold");
+
     p_sys->diarize = var_InheritBool(p_filter, "whisper-diarize");
+    p_sys->carry_context = var_InheritBool(p_filter, "whisper-carry-context");
+    p_sys->fit_audio_ctx = var_InheritBool(p_filter, "whisper-fit-audio-ctx");
+    p_sys->mel_frontend = var_InheritBool(p_filter, "whisper-mel-frontend");
+
+    // Resampling a 16kHz (Requerido por Whisper), hecho en el hilo de audio
+    // con estado entre bloques
+    p_sys->in_rate = p_filter->fmt_in.audio.i_rate;
+    p_sys->resampler.init(p_sys->in_rate, WHISPER_SAMPLE_RATE);
+    p_sys->ingest16.resize(p_sys->resampler.max_output(INGEST_BLOCK));
+
+    char *psz_overload = var_InheritString(p_filter, "whisper-overload");
+    if (psz_overload && !strcmp(psz_overload, "skip-to-live"))
+        p_sys->overload = OVERLOAD_SKIP_TO_LIVE;
+    else if (psz_overload && !strcmp(psz_overload, "degrade"))
+        p_sys->overload = OVERLOAD_DEGRADE;
+    else
+        p_sys->overload = OVERLOAD_DROP_OLDEST;
+    char *psz_fallback = var_InheritString(p_filter, "whisper-fallback-model");
+    p_sys->fallback_model = psz_fallback ? psz_fallback : "";
+    // free(psz_overload); free(psz_fallback); Cross-Heap Allocation Issue caused by mismatched compilers (msvc vs gcc)
+
+    // El backlog máximo cubre al menos una ventana más un paso. La capacidad
+    // del ring deja además sitio para las ventanas en vuelo y una ventana de
+    // margen para que el hilo de audio siga escribiendo mientras tanto.
+    int window_ms = p_sys->chunk_size * 1000;
+    if (p_sys->step_ms > 0)
+        window_ms = p_sys->length_ms + STREAM_KEEP_MS + p_sys->step_ms;
+    int64_t backlog_ms = var_InheritInteger(p_filter, "whisper-max-backlog") * 1000;
+    if (backlog_ms < window_ms) backlog_ms = window_ms;
+    p_sys->max_backlog = (size_t)(WHISPER_SAMPLE_RATE * backlog_ms / 1000);
+    if (!p_sys->pcm_ring.init(p_sys->max_backlog + (p_sys->windows.size() + 1) * WHISPER_SAMPLE_RATE * window_ms / 1000)) {
+        delete p_sys;
+        p_filter->p_sys = NULL;
+        return VLC_ENOMEM;
+    }
+
+    p_sys->model_path = model_path;
+    // free(psz); Cross-Heap Allocation Issue caused by mismatched compilers (msvc vs gcc)
 
     msg_Info(p_filter, "Cargando modelo: %s (Idioma: %s, Traducción: %s, GPU: %s, FlashAttn: %s, Threads: %d, Diarización: %s)", 
              model_path, p_sys->language.c_str(), p_sys->translate ? "SÍ" : "NO",
@@ -240,17 +1439,28 @@ static int OpenAudio(vlc_object_t *obj)
     whisper_context_params cparams = whisper_context_default_params();
     cparams.use_gpu = use_gpu;
     cparams.flash_attn = flash_attn;
+    p_sys->cparams = cparams;
 
-    p_sys->ctx = whisper_init_from_file_with_params(model_path, cparams);
-    // free(psz); Cross-Heap Allocation Issue caused by mismatched compilers (msvc vs gcc)
+    // Parámetros de inferencia: solo el prompt cambia entre ventanas
+    whisper_full_params wp = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    wp.language = p_sys->language.c_str();
+    wp.translate = p_sys->translate;
+    wp.n_threads = p_sys->n_threads;
+    wp.tdrz_enable = p_sys->diarize;
+    wp.abort_callback = AbortInference;
+    wp.abort_callback_user_data = p_sys;
+    wp.token_timestamps = true;
+    // El contexto interno de whisper incluiría el texto provisional del
+    // keep; en su lugar se pasa como prompt solo lo ya entregado
+    wp.no_context = true;
+    wp.single_segment = p_sys->step_ms > 0;
+    p_sys->wparams = wp;
 
-    if (!p_sys->ctx) {
-        msg_Err(p_filter, "Error cargando Whisper");
-        delete p_sys;
-        return VLC_EGENERIC;
-    }
-    
+    // El modelo se carga en el worker para no bloquear el arranque de la
+    // reproducción; el ring acumula audio hasta su capacidad mientras tanto
     p_sys->running = true;
+    CreateStatVars(p_filter);
+    p_sys->captions = AcquireCaptionBoard(obj);
     p_sys->worker_thread = std::thread(WhisperWorker, p_filter);
 
     return VLC_SUCCESS;
@@ -263,15 +1473,131 @@ static void CloseAudio(vlc_object_t *obj)
     
     if (p_sys) {
         msg_Info(p_filter, "Deteniendo hilo de Whisper...");
-        p_sys->running = false;
+        {
+            std::lock_guard<std::mutex> lock(p_sys->wake_mutex);
+            p_sys->running = false;
+        }
+        p_sys->wake_cv.notify_one();
         if (p_sys->worker_thread.joinable())
             p_sys->worker_thread.join();
+        DestroyStatVars(p_filter);
+        caption_board_release(p_sys->captions);
 
+        FreeStates(p_sys);
         if (p_sys->ctx)
-            whisper_free(p_sys->ctx);
+            model_cache_release(p_sys->ctx);
 
         msg_Info(p_filter, "Liberando p_sys de prueba.");
         delete p_sys; 
         p_filter->p_sys = NULL;
     }
 }
+
+/*****************************************************************************
+ * Sub source: dibuja en el vídeo los subtítulos publicados en el tablero
+ *****************************************************************************/
+
+struct sub_sys_t {
+    CaptionBoard *board;
+    uint64_t last_id = 0;       // último subtítulo mostrado o descartado
+    uint32_t last_seq = ~0u;    // generación de snapshot
+    mtime_t prev_start = VLC_TS_INVALID;    // fecha de audio del último final
+    mtime_t prev_shown = VLC_TS_INVALID;    // y cuándo se mostró
+    caption_snapshot_t snapshot;
+};
+
+// Espera máxima de un subtítulo antes de mostrarlo igualmente
+static const mtime_t MAX_CAPTION_WAIT = 5 * CLOCK_FREQ;
+
+// Momento en que debe mostrarse un subtítulo final. Si el vídeo va por detrás
+// del audio, en su propia fecha; si llega tarde (lo normal, la inferencia
+// tarda), cuanto antes pero conservando la separación con el anterior, para
+// que los segmentos de una misma ventana no pasen de golpe.
+static mtime_t CaptionShowDate(const sub_sys_t *p_sys, const caption_t &cap, mtime_t date)
+{
+    mtime_t when = date;
+    if (cap.start > date)
+        when = cap.start;
+    else if (p_sys->prev_shown > VLC_TS_INVALID && cap.start > p_sys->prev_start)
+        when = p_sys->prev_shown + (cap.start - p_sys->prev_start);
+    return (when > date && when - date < MAX_CAPTION_WAIT) ? when : date;
+}
+
+static subpicture_t *RenderCaption(filter_t *p_filter, mtime_t date)
+{
+    sub_sys_t *p_sys = (sub_sys_t *)(void *)p_filter->p_sys;
+
+    // Solo se copia el tablero cuando hay publicaciones nuevas; si la copia
+    // no sale se sigue con la anterior y se reintenta en el próximo frame
+    if (p_sys->board->generation() != p_sys->last_seq && p_sys->board->read(&p_sys->snapshot))
+        p_sys->last_seq = p_sys->snapshot.seq;
+    const caption_snapshot_t &snap = p_sys->snapshot;
+
+    // Los que ya salieron del tablero se pierden, y un parcial que ya tiene
+    // sucesor no llega a mostrarse
+    if (snap.last_id > CAPTION_SLOTS && p_sys->last_id < snap.last_id - CAPTION_SLOTS)
+        p_sys->last_id = snap.last_id - CAPTION_SLOTS;
+    while (p_sys->last_id + 1 < snap.last_id && snap.slots[(p_sys->last_id + 1) % CAPTION_SLOTS].partial)
+        p_sys->last_id++;
+    if (p_sys->last_id >= snap.last_id)
+        return NULL;
+
+    const caption_t &cap = snap.slots[(p_sys->last_id + 1) % CAPTION_SLOTS];
+    mtime_t when = date;
+    if (!cap.partial) {
+        when = CaptionShowDate(p_sys, cap, date);
+        if (when > date)
+            return NULL;
+        p_sys->prev_start = cap.start;
+        p_sys->prev_shown = date;
+    }
+    p_sys->last_id = cap.id;
+
+    subpicture_t *p_spu = filter_NewSubpicture(p_filter);
+    if (!p_spu)
+        return NULL;
+
+    video_format_t fmt;
+    video_format_Init(&fmt, VLC_CODEC_TEXT);
+    fmt.i_width = fmt.i_height = 0;
+    p_spu->p_region = subpicture_region_New(&fmt);
+    video_format_Clean(&fmt);
+    if (!p_spu->p_region) {
+        subpicture_Delete(p_spu);
+        return NULL;
+    }
+
+    p_spu->p_region->p_text = text_segment_New(cap.text);
+    p_spu->p_region->i_align = SUBPICTURE_ALIGN_BOTTOM;
+    p_spu->p_region->i_x = 0;
+    p_spu->p_region->i_y = 20;
+    p_spu->b_absolute = false;
+    p_spu->i_start = when;
+    p_spu->i_stop = when + (cap.stop - cap.start);
+    // Cada subtítulo se retira en cuanto empieza el siguiente
+    p_spu->b_ephemer = true;
+    return p_spu;
+}
+
+static int OpenSub(vlc_object_t *obj)
+{
+    filter_t *p_filter = (filter_t *)obj;
+
+    sub_sys_t *p_sys = new(std::nothrow) sub_sys_t();
+    if (!p_sys) return VLC_ENOMEM;
+    p_sys->board = AcquireCaptionBoard(obj);
+
+    // p_sys está tipado para el filtro de audio de este mismo módulo
+    p_filter->p_sys = (filter_sys_t *)(void *)p_sys;
+    p_filter->pf_sub_source = RenderCaption;
+    return VLC_SUCCESS;
+}
+
+static void CloseSub(vlc_object_t *obj)
+{
+    filter_t *p_filter = (filter_t *)obj;
+    sub_sys_t *p_sys = (sub_sys_t *)(void *)p_filter->p_sys;
+    caption_board_release(p_sys->board);
+    delete p_sys;
+    p_filter->p_sys = NULL;
+}
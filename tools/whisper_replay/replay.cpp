@@ -0,0 +1,586 @@
+// Replay offline del filtro: lee un WAV o PCM crudo y lo pasa por ProcessAudio
+// en bloques como los de VLC, con el mismo worker, resampler, ring e inferencia
+// que dentro del reproductor. Al terminar escribe en stdout un JSON con el
+// factor de tiempo real, la latencia de los subtítulos, la memoria y el audio
+// descartado, para poder reproducir y comparar el rendimiento sin VLC.
+//
+//   whisper_replay -m ggml-base.bin [--block 1024] [--speed 1] entrada.wav
+//
+// El filtro se compila dentro de este mismo fichero para poder leer su estado
+// (ring, contadores) y el tablero de subtítulos sin tocar su interfaz.
+
+#include "whisper_subs.cpp"
+
+#include <cinttypes>
+#include <cmath>
+
+#ifdef _WIN32
+# include <psapi.h>
+#else
+# include <sys/resource.h>
+#endif
+
+#include "vlc_shim.h"
+
+/*****************************************************************************
+ * Entrada
+ *****************************************************************************/
+
+// Fichero de audio leído por bloques, convertido a un formato de VLC
+struct input_t {
+    FILE *f = NULL;
+    unsigned rate = 0;
+    unsigned channels = 0;
+    unsigned file_bytes = 0;    // por muestra en el fichero
+    bool is_float = false;
+    uint64_t data_left = UINT64_MAX;
+    vlc_fourcc_t codec = 0;
+    unsigned out_bytes = 0;     // por muestra en el bloque
+    uint32_t mask = 0;          // canales en la convención de VLC
+    std::vector<unsigned> order;    // canal del fichero para cada posición de VLC
+    std::vector<uint8_t> raw;
+};
+
+// Posiciones de WAVE_FORMAT_EXTENSIBLE en orden de bit, como las traduce VLC
+static const uint32_t wav_channels[] = {
+    AOUT_CHAN_LEFT, AOUT_CHAN_RIGHT, AOUT_CHAN_CENTER, AOUT_CHAN_LFE,
+    AOUT_CHAN_REARLEFT, AOUT_CHAN_REARRIGHT, 0, 0,
+    AOUT_CHAN_REARCENTER, AOUT_CHAN_MIDDLELEFT, AOUT_CHAN_MIDDLERIGHT,
+};
+
+// Máscara de los WAV sin dwChannelMask (y del PCM crudo), por número de canales
+static const uint32_t wav_default_masks[] = {
+    0, 0x4, 0x3, 0x7, 0x33, 0x37, 0x3f, 0x70f, 0x63f,
+};
+
+// Reordena los canales del fichero al orden interno de VLC (pi_chan_order);
+// si la máscara no describe todos los canales se dejan como están y el
+// filtro hace un downmix por media
+static void SetupLayout(input_t *in, uint32_t wav_mask)
+{
+    std::vector<uint32_t> file_pos;
+    for (unsigned bit = 0; bit < sizeof(wav_channels) / sizeof(wav_channels[0]); ++bit)
+        if ((wav_mask & (1u << bit)) && wav_channels[bit])
+            file_pos.push_back(wav_channels[bit]);
+
+    in->order.clear();
+    in->mask = 0;
+    if (file_pos.size() == in->channels) {
+        for (uint32_t c : pi_chan_order)
+            for (unsigned i = 0; i < file_pos.size(); ++i)
+                if (file_pos[i] == c) {
+                    in->order.push_back(i);
+                    in->mask |= c;
+                }
+    }
+    if (in->order.size() != in->channels) {
+        in->order.clear();
+        in->mask = 0;
+        for (unsigned i = 0; i < in->channels; ++i)
+            in->order.push_back(i);
+    }
+}
+
+// Formato de VLC que recibe el filtro: los enteros de 8 y 24 bits se amplían
+static bool SetupFormat(input_t *in)
+{
+    if (in->is_float) {
+        if (in->file_bytes == 4) { in->codec = VLC_CODEC_FL32; in->out_bytes = 4; return true; }
+        if (in->file_bytes == 8) { in->codec = VLC_CODEC_FL64; in->out_bytes = 8; return true; }
+        return false;
+    }
+    switch (in->file_bytes) {
+        case 1: case 2: in->codec = VLC_CODEC_S16N; in->out_bytes = 2; return true;
+        case 3: case 4: in->codec = VLC_CODEC_S32N; in->out_bytes = 4; return true;
+    }
+    return false;
+}
+
+static uint32_t ReadLE(const uint8_t *p, unsigned n)
+{
+    uint32_t v = 0;
+    for (unsigned i = 0; i < n; ++i)
+        v |= (uint32_t)p[i] << (8 * i);
+    return v;
+}
+
+static bool OpenWav(input_t *in, const char *path, std::string *err)
+{
+    in->f = fopen(path, "rb");
+    if (!in->f) {
+        *err = std::string("no se puede abrir ") + path;
+        return false;
+    }
+
+    uint8_t hdr[12];
+    if (fread(hdr, 1, 12, in->f) != 12 || memcmp(hdr, "RIFF", 4) || memcmp(hdr + 8, "WAVE", 4)) {
+        *err = "no es un fichero RIFF/WAVE";
+        return false;
+    }
+
+    bool have_fmt = false;
+    uint32_t wav_mask = 0;
+    for (;;) {
+        uint8_t chunk[8];
+        if (fread(chunk, 1, 8, in->f) != 8) {
+            *err = "no hay chunk data";
+            return false;
+        }
+        const uint32_t size = ReadLE(chunk + 4, 4);
+
+        if (!memcmp(chunk, "fmt ", 4)) {
+            uint8_t fmt[40] = {};
+            const size_t n = size < sizeof(fmt) ? size : sizeof(fmt);
+            if (size < 16 || fread(fmt, 1, n, in->f) != n) {
+                *err = "chunk fmt inválido";
+                return false;
+            }
+            uint32_t tag = ReadLE(fmt, 2);
+            in->channels = ReadLE(fmt + 2, 2);
+            in->rate = ReadLE(fmt + 4, 4);
+            in->file_bytes = ReadLE(fmt + 14, 2) / 8;
+            if (tag == 0xFFFE && size >= 40) {
+                wav_mask = ReadLE(fmt + 20, 4);
+                tag = ReadLE(fmt + 24, 2);  // primeros bytes del GUID del subformato
+            }
+            if (tag != 1 && tag != 3) {
+                *err = "solo se admite PCM entero o float";
+                return false;
+            }
+            in->is_float = tag == 3;
+            fseek(in->f, (long)(size - n + (size & 1)), SEEK_CUR);
+            have_fmt = true;
+        } else if (!memcmp(chunk, "data", 4)) {
+            // 0 o 0xFFFFFFFF: escrito en streaming, se lee hasta el final
+            if (size != 0 && size != 0xFFFFFFFF)
+                in->data_left = size;
+            break;
+        } else {
+            fseek(in->f, (long)(size + (size & 1)), SEEK_CUR);
+        }
+    }
+
+    if (!have_fmt || in->channels == 0 || in->rate == 0 || !SetupFormat(in)) {
+        *err = "formato de muestra no soportado";
+        return false;
+    }
+    if (!wav_mask && in->channels < sizeof(wav_default_masks) / sizeof(wav_default_masks[0]))
+        wav_mask = wav_default_masks[in->channels];
+    SetupLayout(in, wav_mask);
+    return true;
+}
+
+// "s16:48000:2": formato (u8, s16, s24, s32, f32, f64), frecuencia y canales
+static bool OpenRaw(input_t *in, const char *path, const char *spec, std::string *err)
+{
+    char fmt[8];
+    if (sscanf(spec, "%7[^:]:%u:%u", fmt, &in->rate, &in->channels) != 3 || !in->rate || !in->channels) {
+        *err = std::string("--raw inválido: ") + spec;
+        return false;
+    }
+    in->is_float = fmt[0] == 'f';
+    in->file_bytes = (unsigned)atoi(fmt + 1) / 8;
+    if ((fmt[0] != 'u' && fmt[0] != 's' && fmt[0] != 'f') || (fmt[0] == 'u') != (in->file_bytes == 1)
+     || !SetupFormat(in)) {
+        *err = std::string("formato crudo no soportado: ") + fmt;
+        return false;
+    }
+
+    in->f = fopen(path, "rb");
+    if (!in->f) {
+        *err = std::string("no se puede abrir ") + path;
+        return false;
+    }
+    SetupLayout(in, in->channels < sizeof(wav_default_masks) / sizeof(wav_default_masks[0])
+                    ? wav_default_masks[in->channels] : 0);
+    return true;
+}
+
+// Lee hasta frames tramas en out (formato in->codec, orden de VLC)
+static size_t ReadBlock(input_t *in, std::vector<uint8_t> &out, size_t frames)
+{
+    const size_t frame_bytes = (size_t)in->file_bytes * in->channels;
+    uint64_t want = (uint64_t)frames * frame_bytes;
+    if (want > in->data_left)
+        want = in->data_left - in->data_left % frame_bytes;
+    in->raw.resize((size_t)want);
+    frames = fread(in->raw.data(), 1, (size_t)want, in->f) / frame_bytes;
+    if (in->data_left != UINT64_MAX)
+        in->data_left -= frames * frame_bytes;
+
+    out.resize(frames * in->channels * in->out_bytes);
+    for (size_t i = 0; i < frames; ++i)
+        for (unsigned c = 0; c < in->channels; ++c) {
+            const uint8_t *s = &in->raw[i * frame_bytes + in->order[c] * in->file_bytes];
+            uint8_t *d = &out[(i * in->channels + c) * in->out_bytes];
+            if (in->file_bytes == 1) {
+                const int16_t v = (int16_t)((s[0] - 128) << 8);
+                memcpy(d, &v, 2);
+            } else if (in->file_bytes == 3) {
+                const int32_t v = (int32_t)ReadLE(s, 3) << 8;
+                memcpy(d, &v, 4);
+            } else {
+                memcpy(d, s, in->out_bytes);
+            }
+        }
+    return frames;
+}
+
+/*****************************************************************************
+ * Medidas
+ *****************************************************************************/
+
+struct published_t {
+    mtime_t start;      // fecha del primer token (dominio de los pts)
+    mtime_t seen;       // mdate() al verlo en el tablero
+    bool partial;
+    std::string text;
+};
+
+// Lee el tablero como lo haría el sub source, pero sin perder ninguno
+class CaptionMonitor {
+public:
+    void start(const CaptionBoard *board)
+    {
+        board_ = board;
+        running_ = true;
+        thread_ = std::thread(&CaptionMonitor::run, this);
+    }
+
+    void stop()
+    {
+        running_ = false;
+        thread_.join();
+        poll();
+    }
+
+    std::vector<published_t> captions;
+    unsigned missed = 0;    // sobrescritos en el tablero antes de leerlos
+
+private:
+    void run()
+    {
+        while (running_) {
+            poll();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    void poll()
+    {
+        if (board_->generation() == last_seq_)
+            return;
+        const mtime_t now = mdate();
+        if (!board_->read(&snap_))
+            return;
+        last_seq_ = snap_.seq;
+        for (uint64_t id = last_id_ + 1; id <= snap_.last_id; ++id) {
+            const caption_t &c = snap_.slots[id % CAPTION_SLOTS];
+            if (c.id != id) {
+                missed++;
+                continue;
+            }
+            captions.push_back(published_t{ c.start, now, c.partial, c.text });
+        }
+        last_id_ = snap_.last_id;
+    }
+
+    const CaptionBoard *board_ = nullptr;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+    caption_snapshot_t snap_;
+    uint32_t last_seq_ = 0;
+    uint64_t last_id_ = 0;
+};
+
+// El worker está parado hasta que llegue más audio: necesita una ventana
+// completa y el ring aún no la tiene
+static bool WorkerWantsAudio(filter_sys_t *p_sys)
+{
+    std::lock_guard<std::mutex> lock(p_sys->wake_mutex);
+    const size_t need = p_sys->wake_samples.load(std::memory_order_relaxed);
+    return p_sys->worker_idle.load(std::memory_order_relaxed)
+        && need != SIZE_MAX && p_sys->pcm_ring.size() < need;
+}
+
+// El worker espera audio que ya no va a llegar y no queda nada en vuelo.
+// Se mira con wake_mutex tomado, como el propio worker.
+static bool WorkerDrained(filter_sys_t *p_sys)
+{
+    std::lock_guard<std::mutex> lock(p_sys->wake_mutex);
+    if (!p_sys->worker_idle.load(std::memory_order_relaxed))
+        return false;
+    for (const window_job_t &w : p_sys->windows)
+        if (!w.done.load(std::memory_order_acquire))
+            return false;
+    const size_t need = p_sys->wake_samples.load(std::memory_order_relaxed);
+    return need != SIZE_MAX && p_sys->pcm_ring.size() < need;
+}
+
+static double PeakRssMiB()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (!K32GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return 0.0;
+    return pmc.PeakWorkingSetSize / (1024.0 * 1024.0);
+#else
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0)
+        return 0.0;
+# ifdef __APPLE__
+    return ru.ru_maxrss / (1024.0 * 1024.0);   // bytes
+# else
+    return ru.ru_maxrss / 1024.0;              // KiB
+# endif
+#endif
+}
+
+static double Percentile(std::vector<double> v, double p)
+{
+    if (v.empty())
+        return 0.0;
+    std::sort(v.begin(), v.end());
+    const size_t i = (size_t)std::ceil(p / 100.0 * v.size());
+    return v[i ? i - 1 : 0];
+}
+
+static void PrintLatency(const char *name, const std::vector<double> &ms)
+{
+    printf("  \"%s\": { \"count\": %zu, \"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, \"max\": %.1f },\n",
+           name, ms.size(), Percentile(ms, 50), Percentile(ms, 90), Percentile(ms, 99), Percentile(ms, 100));
+}
+
+static std::string JsonString(const char *s)
+{
+    std::string out = "\"";
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\')
+            out += '\\';
+        if ((unsigned char)*s < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", *s);
+            out += buf;
+        } else {
+            out += *s;
+        }
+    }
+    return out + "\"";
+}
+
+/*****************************************************************************
+ * main
+ *****************************************************************************/
+
+static void Usage(const char *argv0)
+{
+    fprintf(stderr,
+        "uso: %s -m MODELO [opciones] ENTRADA\n"
+        "  -m, --model PATH      modelo ggml (whisper-model)\n"
+        "  --raw FMT:HZ:CANALES  ENTRADA es PCM crudo (u8, s16, s24, s32, f32, f64)\n"
+        "  --block N             tramas por bloque de audio (1024)\n"
+        "  --speed X             velocidad de reproducción; 0 = tan rápido como\n"
+        "                        el worker lo consuma, sin descartar audio (1)\n"
+        "  --opt NOMBRE=VALOR    cualquier opción del filtro (repetible)\n"
+        "  --captions FICHERO    subtítulos finales: inicio, latencia y texto\n"
+        "  --timeout S           espera máxima sin que el worker avance, con\n"
+        "                        --speed 0 y tras el final de la entrada (600)\n"
+        "  -v, -vv               log del filtro en stderr\n", argv0);
+}
+
+int main(int argc, char **argv)
+{
+    shim_module_register();
+
+    const char *input_path = NULL, *raw_spec = NULL, *captions_path = NULL;
+    size_t block_frames = 1024;
+    double speed = 1.0, timeout_s = 600.0;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *a = argv[i];
+        const bool has_value = i + 1 < argc;
+        if ((!strcmp(a, "-m") || !strcmp(a, "--model")) && has_value)
+            shim_set_option("whisper-model", argv[++i]);
+        else if (!strcmp(a, "--raw") && has_value)
+            raw_spec = argv[++i];
+        else if (!strcmp(a, "--block") && has_value)
+            block_frames = strtoul(argv[++i], NULL, 10);
+        else if (!strcmp(a, "--speed") && has_value)
+            speed = atof(argv[++i]);
+        else if (!strcmp(a, "--captions") && has_value)
+            captions_path = argv[++i];
+        else if (!strcmp(a, "--timeout") && has_value)
+            timeout_s = atof(argv[++i]);
+        else if (!strcmp(a, "--opt") && has_value) {
+            std::string opt = argv[++i];
+            const size_t eq = opt.find('=');
+            if (eq == std::string::npos || !shim_set_option(opt.substr(0, eq).c_str(), opt.c_str() + eq + 1)) {
+                fprintf(stderr, "opción inválida: %s\n", opt.c_str());
+                return 2;
+            }
+        }
+        else if (!strcmp(a, "-v"))
+            shim_set_verbosity(1);
+        else if (!strcmp(a, "-vv"))
+            shim_set_verbosity(2);
+        else if (a[0] != '-' && !input_path)
+            input_path = a;
+        else {
+            Usage(argv[0]);
+            return 2;
+        }
+    }
+    if (!input_path || block_frames == 0 || speed < 0.0) {
+        Usage(argv[0]);
+        return 2;
+    }
+
+    input_t in;
+    std::string err;
+    if (!(raw_spec ? OpenRaw(&in, input_path, raw_spec, &err) : OpenWav(&in, input_path, &err))) {
+        fprintf(stderr, "%s: %s\n", input_path, err.c_str());
+        return 1;
+    }
+
+    filter_t filter;
+    memset(&filter, 0, sizeof(filter));
+    filter.obj.psz_object_type = "audio filter";
+    filter.fmt_in.i_codec = in.codec;
+    filter.fmt_in.audio.i_format = in.codec;
+    filter.fmt_in.audio.i_rate = in.rate;
+    filter.fmt_in.audio.i_channels = in.channels;
+    filter.fmt_in.audio.i_physical_channels = (uint16_t)in.mask;
+    filter.fmt_in.audio.i_bitspersample = in.out_bytes * 8;
+    filter.fmt_out = filter.fmt_in;
+
+    if (OpenAudio(VLC_OBJECT(&filter)) != VLC_SUCCESS) {
+        fprintf(stderr, "no se pudo abrir el filtro\n");
+        return 1;
+    }
+    filter_sys_t *p_sys = filter.p_sys;
+
+    // El modelo se carga en el worker; la medida empieza con el modelo listo
+    const mtime_t load_start = mdate();
+    while (!p_sys->worker_idle.load() && p_sys->ingest.load())
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    if (!p_sys->ingest.load()) {
+        fprintf(stderr, "no se pudo cargar el modelo\n");
+        CloseAudio(VLC_OBJECT(&filter));
+        return 1;
+    }
+    const mtime_t t0 = mdate();
+
+    // El monitor hace de sub source: toma su propia referencia al tablero
+    CaptionBoard *board = AcquireCaptionBoard(VLC_OBJECT(&filter));
+    CaptionMonitor monitor;
+    monitor.start(board);
+
+    // Bloques con pts consecutivos desde t0; se guarda cuándo se entregó cada
+    // uno para medir la latencia de un subtítulo desde la llegada de su audio
+    std::vector<mtime_t> block_pts, block_pushed;
+    std::vector<uint8_t> buf;
+    uint64_t frames_in = 0;
+    const size_t block16 = block_frames * WHISPER_SAMPLE_RATE / in.rate + 16;
+    bool stalled = false;
+    for (;;) {
+        const size_t n = ReadBlock(&in, buf, block_frames);
+        if (n == 0)
+            break;
+
+        const mtime_t media = (mtime_t)(frames_in * CLOCK_FREQ / in.rate);
+        if (speed > 0.0) {
+            const mtime_t due = t0 + (mtime_t)(media / speed);
+            const mtime_t now = mdate();
+            if (due > now)
+                std::this_thread::sleep_for(std::chrono::microseconds(due - now));
+        } else {
+            // Sin reloj: se entrega en cuanto el backlog baja, por debajo del
+            // punto en que la política de sobrecarga empezaría a descartar, o
+            // antes si el worker espera una ventana mayor que ese umbral
+            const mtime_t give_up = mdate() + (mtime_t)(timeout_s * CLOCK_FREQ);
+            while (p_sys->pcm_ring.size() + block16 > p_sys->max_backlog / 2 && !WorkerWantsAudio(p_sys)) {
+                if (mdate() > give_up) {
+                    stalled = true;
+                    break;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            if (stalled) {
+                fprintf(stderr, "el worker no avanza en %.0f s, se corta la entrada\n", timeout_s);
+                break;
+            }
+        }
+
+        block_t block;
+        memset(&block, 0, sizeof(block));
+        block.p_buffer = buf.data();
+        block.i_buffer = buf.size();
+        block.i_nb_samples = (unsigned)n;
+        block.i_pts = block.i_dts = t0 + media;
+        block.i_length = (mtime_t)(n * CLOCK_FREQ / in.rate);
+
+        block_pts.push_back(block.i_pts);
+        block_pushed.push_back(mdate());
+        filter.pf_audio_filter(&filter, &block);
+        frames_in += n;
+    }
+    fclose(in.f);
+    const mtime_t input_end = mdate();
+
+    // Dos lecturas seguidas por si el worker acaba de recibir un resultado
+    const mtime_t deadline = input_end + (mtime_t)(timeout_s * CLOCK_FREQ);
+    bool drained = false;
+    while (!stalled && !drained && mdate() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        drained = WorkerDrained(p_sys);
+        if (drained) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            drained = WorkerDrained(p_sys);
+        }
+    }
+    const mtime_t t_end = mdate();
+
+    const uint64_t dropped_overload = p_sys->dropped_overload.load();
+    const uint64_t dropped_overrun = p_sys->dropped_overrun.load();
+
+    CloseAudio(VLC_OBJECT(&filter));
+    monitor.stop();
+    caption_board_release(board);
+
+    const double audio_s = (double)frames_in / in.rate;
+    const double wall_s = (double)(t_end - t0) / CLOCK_FREQ;
+
+    std::vector<double> final_ms, partial_ms;
+    FILE *captions = captions_path ? fopen(captions_path, "w") : NULL;
+    for (const published_t &c : monitor.captions) {
+        auto it = std::upper_bound(block_pts.begin(), block_pts.end(), c.start);
+        if (it == block_pts.begin())
+            continue;   // sin fecha en el dominio de los pts
+        const mtime_t pushed = block_pushed[it - block_pts.begin() - 1];
+        const double ms = (double)(c.seen - pushed) / 1000.0;
+        (c.partial ? partial_ms : final_ms).push_back(ms);
+        if (captions && !c.partial)
+            fprintf(captions, "%.2f\t%.2f\t%s\n", (double)(c.start - t0) / CLOCK_FREQ, ms / 1000.0, c.text.c_str());
+    }
+    if (captions)
+        fclose(captions);
+
+    printf("{\n");
+    printf("  \"input\": %s,\n", JsonString(input_path).c_str());
+    printf("  \"audio_s\": %.3f,\n", audio_s);
+    printf("  \"rate\": %u,\n  \"channels\": %u,\n  \"block_frames\": %zu,\n  \"speed\": %g,\n",
+           in.rate, in.channels, block_frames, speed);
+    printf("  \"model_load_s\": %.3f,\n", (double)(t0 - load_start) / CLOCK_FREQ);
+    printf("  \"wall_s\": %.3f,\n", wall_s);
+    printf("  \"drain_s\": %.3f,\n", (double)(t_end - input_end) / CLOCK_FREQ);
+    printf("  \"rtf\": %.3f,\n", audio_s > 0.0 ? wall_s / audio_s : 0.0);
+    printf("  \"drained\": %s,\n", drained ? "true" : "false");
+    PrintLatency("caption_latency_ms", final_ms);
+    PrintLatency("partial_latency_ms", partial_ms);
+    printf("  \"captions_missed\": %u,\n", monitor.missed);
+    printf("  \"peak_rss_mib\": %.1f,\n", PeakRssMiB());
+    printf("  \"dropped_s\": { \"overload\": %.3f, \"overrun\": %.3f }\n",
+           (double)dropped_overload / WHISPER_SAMPLE_RATE, (double)dropped_overrun / WHISPER_SAMPLE_RATE);
+    printf("}\n");
+    return drained ? 0 : 3;
+}
@@ -0,0 +1,15 @@
+#ifndef WHISPER_REPLAY_VLC_BLOCK_H
+#define WHISPER_REPLAY_VLC_BLOCK_H
+
+#include "vlc_common.h"
+
+typedef struct block_t {
+    uint8_t *p_buffer;
+    size_t i_buffer;
+    unsigned i_nb_samples;
+    mtime_t i_pts;
+    mtime_t i_dts;
+    mtime_t i_length;
+} block_t;
+
+#endif
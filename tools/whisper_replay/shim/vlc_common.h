@@ -0,0 +1,81 @@
+#ifndef WHISPER_REPLAY_VLC_COMMON_H
+#define WHISPER_REPLAY_VLC_COMMON_H
+
+// Sustituto mínimo de la API de VLC 3 para ejecutar el filtro fuera del
+// reproductor (tools/whisper_replay). Solo declara lo que usa whisper_subs.cpp;
+// las implementaciones están en vlc_shim.cpp.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+typedef int64_t mtime_t;
+typedef uint32_t vlc_fourcc_t;
+
+#define VLC_SUCCESS     0
+#define VLC_EGENERIC    (-1)
+#define VLC_ENOMEM      (-2)
+
+#define VLC_FOURCC(a, b, c, d) \
+    ((uint32_t)(unsigned char)(a) | ((uint32_t)(unsigned char)(b) << 8) | \
+     ((uint32_t)(unsigned char)(c) << 16) | ((uint32_t)(unsigned char)(d) << 24))
+
+#define VLC_CODEC_FL32  VLC_FOURCC('f','l','3','2')
+#define VLC_CODEC_FL64  VLC_FOURCC('f','l','6','4')
+#define VLC_CODEC_S16N  VLC_FOURCC('s','1','6','l')
+#define VLC_CODEC_S32N  VLC_FOURCC('s','3','2','l')
+#define VLC_CODEC_TEXT  VLC_FOURCC('T','E','X','T')
+
+#define VLC_TS_INVALID  INT64_C(0)
+#define VLC_TS_0        INT64_C(1)
+#define CLOCK_FREQ      INT64_C(1000000)
+
+#define VLC_VAR_BOOL    0x0020
+#define VLC_VAR_INTEGER 0x0030
+#define VLC_VAR_STRING  0x0040
+#define VLC_VAR_FLOAT   0x0050
+
+// Misma disposición que en VLC 3: la cabecera común va en el miembro obj
+struct vlc_common_members {
+    const char *psz_object_type;
+    struct vlc_object_t *parent;
+};
+
+typedef struct vlc_object_t {
+    struct vlc_common_members obj;
+} vlc_object_t;
+
+#define VLC_OBJECT(x) ((vlc_object_t *)&(x)->obj)
+
+// Reloj monótono en microsegundos, como el de VLC
+mtime_t mdate(void);
+
+// Niveles de vlc_Log: 0 info, 1 error, 2 aviso, 3 depuración
+void shim_msg(vlc_object_t *, int level, const char *fmt, ...);
+#define msg_Info(o, ...)    shim_msg(VLC_OBJECT(o), 0, __VA_ARGS__)
+#define msg_Err(o, ...)     shim_msg(VLC_OBJECT(o), 1, __VA_ARGS__)
+#define msg_Warn(o, ...)    shim_msg(VLC_OBJECT(o), 2, __VA_ARGS__)
+#define msg_Dbg(o, ...)     shim_msg(VLC_OBJECT(o), 3, __VA_ARGS__)
+
+// Variables: un único espacio de nombres para todo el proceso, con los
+// valores por defecto de vlc_module_begin y lo que se pase por --opt
+char *shim_var_InheritString(vlc_object_t *, const char *);
+int64_t shim_var_InheritInteger(vlc_object_t *, const char *);
+bool shim_var_InheritBool(vlc_object_t *, const char *);
+float shim_var_InheritFloat(vlc_object_t *, const char *);
+int shim_var_Create(vlc_object_t *, const char *, int type);
+void shim_var_Destroy(vlc_object_t *, const char *);
+void shim_var_SetInteger(vlc_object_t *, const char *, int64_t);
+void shim_var_SetFloat(vlc_object_t *, const char *, float);
+
+#define var_InheritString(o, n)     shim_var_InheritString(VLC_OBJECT(o), n)
+#define var_InheritInteger(o, n)    shim_var_InheritInteger(VLC_OBJECT(o), n)
+#define var_InheritBool(o, n)       shim_var_InheritBool(VLC_OBJECT(o), n)
+#define var_InheritFloat(o, n)      shim_var_InheritFloat(VLC_OBJECT(o), n)
+#define var_Create(o, n, t)         shim_var_Create(VLC_OBJECT(o), n, t)
+#define var_Destroy(o, n)           shim_var_Destroy(VLC_OBJECT(o), n)
+#define var_SetInteger(o, n, v)     shim_var_SetInteger(VLC_OBJECT(o), n, v)
+#define var_SetFloat(o, n, v)       shim_var_SetFloat(VLC_OBJECT(o), n, v)
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef WHISPER_REPLAY_VLC_FILTER_H
+#define WHISPER_REPLAY_VLC_FILTER_H
+
+#include "vlc_common.h"
+#include "vlc_block.h"
+#include "vlc_subpicture.h"
+
+typedef struct audio_format_t {
+    vlc_fourcc_t i_format;
+    unsigned i_rate;
+    uint16_t i_physical_channels;
+    unsigned i_channels;
+    unsigned i_bitspersample;
+} audio_format_t;
+
+typedef struct es_format_t {
+    vlc_fourcc_t i_codec;
+    audio_format_t audio;
+} es_format_t;
+
+struct filter_sys_t;
+
+typedef struct filter_t {
+    struct vlc_common_members obj;
+    es_format_t fmt_in, fmt_out;
+    struct filter_sys_t *p_sys;
+    block_t *(*pf_audio_filter)(struct filter_t *, block_t *);
+    subpicture_t *(*pf_sub_source)(struct filter_t *, mtime_t);
+} filter_t;
+
+subpicture_t *filter_NewSubpicture(filter_t *);
+
+#define AOUT_CHAN_CENTER        0x1
+#define AOUT_CHAN_LEFT          0x2
+#define AOUT_CHAN_RIGHT         0x4
+#define AOUT_CHAN_REARCENTER    0x10
+#define AOUT_CHAN_REARLEFT      0x20
+#define AOUT_CHAN_REARRIGHT     0x40
+#define AOUT_CHAN_MIDDLELEFT    0x100
+#define AOUT_CHAN_MIDDLERIGHT   0x200
+#define AOUT_CHAN_LFE           0x1000
+
+#endif
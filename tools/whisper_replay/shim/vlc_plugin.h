@@ -0,0 +1,38 @@
+#ifndef WHISPER_REPLAY_VLC_PLUGIN_H
+#define WHISPER_REPLAY_VLC_PLUGIN_H
+
+#include "vlc_common.h"
+
+// La descripción del módulo se convierte en una función que registra los
+// valores por defecto de las opciones; el resto de macros no hace nada.
+
+void shim_add_string(const char *name, const char *value);
+void shim_add_integer(const char *name, int64_t value);
+void shim_add_bool(const char *name, bool value);
+void shim_add_float(const char *name, float value);
+
+#define vlc_module_begin()  static void shim_module_register(void) {
+#define vlc_module_end()    }
+
+#define add_submodule()
+#define add_shortcut(...)
+#define set_description(s)
+#define set_shortname(s)
+#define set_capability(c, p)
+#define set_category(c)
+#define set_subcategory(c)
+#define set_section(a, b)
+#define set_callbacks(a, b)     (void)(a); (void)(b);
+
+#define add_string(n, v, t, l, a)   shim_add_string(n, v);
+#define add_integer(n, v, t, l, a)  shim_add_integer(n, v);
+#define add_bool(n, v, t, l, a)     shim_add_bool(n, v);
+#define add_float(n, v, t, l, a)    shim_add_float(n, v);
+#define change_string_list(v, t)
+
+#define CAT_AUDIO               0
+#define SUBCAT_AUDIO_AFILTER    0
+#define CAT_VIDEO               0
+#define SUBCAT_VIDEO_SUBPIC     0
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef WHISPER_REPLAY_VLC_SUBPICTURE_H
+#define WHISPER_REPLAY_VLC_SUBPICTURE_H
+
+#include "vlc_common.h"
+
+typedef struct text_segment_t {
+    char *psz_text;
+    struct text_segment_t *p_next;
+} text_segment_t;
+
+typedef struct video_format_t {
+    vlc_fourcc_t i_chroma;
+    unsigned i_width, i_height;
+    unsigned i_visible_width, i_visible_height;
+    unsigned i_sar_num, i_sar_den;
+} video_format_t;
+
+#define SUBPICTURE_ALIGN_LEFT   0x1
+#define SUBPICTURE_ALIGN_RIGHT  0x2
+#define SUBPICTURE_ALIGN_TOP    0x4
+#define SUBPICTURE_ALIGN_BOTTOM 0x8
+
+typedef struct subpicture_region_t {
+    video_format_t fmt;
+    int i_x, i_y, i_align;
+    text_segment_t *p_text;
+    int i_text_align;
+    struct subpicture_region_t *p_next;
+} subpicture_region_t;
+
+typedef struct subpicture_t {
+    mtime_t i_start, i_stop;
+    bool b_ephemer, b_absolute, b_subtitle;
+    int i_original_picture_width, i_original_picture_height;
+    subpicture_region_t *p_region;
+} subpicture_t;
+
+text_segment_t *text_segment_New(const char *);
+void video_format_Init(video_format_t *, vlc_fourcc_t);
+void video_format_Clean(video_format_t *);
+subpicture_region_t *subpicture_region_New(const video_format_t *);
+void subpicture_Delete(subpicture_t *);
+
+#endif
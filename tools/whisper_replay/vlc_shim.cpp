@@ -0,0 +1,230 @@
+#include <cerrno>
+#include <chrono>
+#include <cstdarg>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_filter.h>
+
+#include "vlc_shim.h"
+
+// Valor de una opción o variable con el tipo con que se registró
+struct shim_var_t {
+    int type;
+    std::string s;
+    int64_t i = 0;
+    bool b = false;
+    float f = 0.0f;
+};
+
+static std::mutex vars_lock;
+static std::map<std::string, shim_var_t> vars;
+static int verbosity = 0;
+
+mtime_t mdate(void)
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void shim_msg(vlc_object_t *, int level, const char *fmt, ...)
+{
+    static const int min_verbosity[] = { 1, 0, 1, 2 };
+    static const char *const names[] = { "info", "error", "warning", "debug" };
+    if (level < 0 || level > 3 || verbosity < min_verbosity[level])
+        return;
+
+    static std::mutex log_lock;
+    std::lock_guard<std::mutex> guard(log_lock);
+    va_list ap;
+    va_start(ap, fmt);
+    fprintf(stderr, "whisper_subs %s: ", names[level]);
+    vfprintf(stderr, fmt, ap);
+    fputc('\n', stderr);
+    va_end(ap);
+}
+
+void shim_set_verbosity(int level)
+{
+    verbosity = level;
+}
+
+static void shim_add(const char *name, const shim_var_t &v)
+{
+    std::lock_guard<std::mutex> guard(vars_lock);
+    vars[name] = v;
+}
+
+void shim_add_string(const char *name, const char *value)
+{
+    shim_var_t v;
+    v.type = VLC_VAR_STRING;
+    v.s = value ? value : "";
+    shim_add(name, v);
+}
+
+void shim_add_integer(const char *name, int64_t value)
+{
+    shim_var_t v;
+    v.type = VLC_VAR_INTEGER;
+    v.i = value;
+    shim_add(name, v);
+}
+
+void shim_add_bool(const char *name, bool value)
+{
+    shim_var_t v;
+    v.type = VLC_VAR_BOOL;
+    v.b = value;
+    shim_add(name, v);
+}
+
+void shim_add_float(const char *name, float value)
+{
+    shim_var_t v;
+    v.type = VLC_VAR_FLOAT;
+    v.f = value;
+    shim_add(name, v);
+}
+
+bool shim_set_option(const char *name, const char *value)
+{
+    std::lock_guard<std::mutex> guard(vars_lock);
+    auto it = vars.find(name);
+    if (it == vars.end())
+        return false;
+
+    shim_var_t &v = it->second;
+    char *end;
+    errno = 0;
+    switch (v.type) {
+        case VLC_VAR_STRING:
+            v.s = value;
+            return true;
+        case VLC_VAR_INTEGER:
+            v.i = strtoll(value, &end, 10);
+            return errno == 0 && end != value && *end == '\0';
+        case VLC_VAR_FLOAT:
+            v.f = strtof(value, &end);
+            return errno == 0 && end != value && *end == '\0';
+        case VLC_VAR_BOOL:
+            if (!strcmp(value, "1") || !strcmp(value, "true") || !strcmp(value, "yes"))
+                v.b = true;
+            else if (!strcmp(value, "0") || !strcmp(value, "false") || !strcmp(value, "no"))
+                v.b = false;
+            else
+                return false;
+            return true;
+    }
+    return false;
+}
+
+// Como en VLC, una opción que no existe hereda el valor nulo de su tipo
+char *shim_var_InheritString(vlc_object_t *, const char *name)
+{
+    std::lock_guard<std::mutex> guard(vars_lock);
+    auto it = vars.find(name);
+    return it != vars.end() && it->second.type == VLC_VAR_STRING ? strdup(it->second.s.c_str()) : NULL;
+}
+
+int64_t shim_var_InheritInteger(vlc_object_t *, const char *name)
+{
+    std::lock_guard<std::mutex> guard(vars_lock);
+    auto it = vars.find(name);
+    return it != vars.end() ? it->second.i : 0;
+}
+
+bool shim_var_InheritBool(vlc_object_t *, const char *name)
+{
+    std::lock_guard<std::mutex> guard(vars_lock);
+    auto it = vars.find(name);
+    return it != vars.end() && it->second.b;
+}
+
+float shim_var_InheritFloat(vlc_object_t *, const char *name)
+{
+    std::lock_guard<std::mutex> guard(vars_lock);
+    auto it = vars.find(name);
+    return it != vars.end() ? it->second.f : 0.0f;
+}
+
+int shim_var_Create(vlc_object_t *, const char *name, int type)
+{
+    std::lock_guard<std::mutex> guard(vars_lock);
+    shim_var_t &v = vars[name];
+    v.type = type;
+    return VLC_SUCCESS;
+}
+
+void shim_var_Destroy(vlc_object_t *, const char *name)
+{
+    std::lock_guard<std::mutex> guard(vars_lock);
+    vars.erase(name);
+}
+
+void shim_var_SetInteger(vlc_object_t *, const char *name, int64_t value)
+{
+    std::lock_guard<std::mutex> guard(vars_lock);
+    vars[name].i = value;
+}
+
+void shim_var_SetFloat(vlc_object_t *, const char *name, float value)
+{
+    std::lock_guard<std::mutex> guard(vars_lock);
+    vars[name].f = value;
+}
+
+/* Sub source: solo hace falta para enlazar; el replay lee el tablero */
+
+subpicture_t *filter_NewSubpicture(filter_t *)
+{
+    return (subpicture_t *)calloc(1, sizeof(subpicture_t));
+}
+
+text_segment_t *text_segment_New(const char *text)
+{
+    text_segment_t *seg = (text_segment_t *)calloc(1, sizeof(text_segment_t));
+    if (seg && text && !(seg->psz_text = strdup(text))) {
+        free(seg);
+        return NULL;
+    }
+    return seg;
+}
+
+void video_format_Init(video_format_t *fmt, vlc_fourcc_t chroma)
+{
+    memset(fmt, 0, sizeof(*fmt));
+    fmt->i_chroma = chroma;
+}
+
+void video_format_Clean(video_format_t *fmt)
+{
+    memset(fmt, 0, sizeof(*fmt));
+}
+
+subpicture_region_t *subpicture_region_New(const video_format_t *fmt)
+{
+    subpicture_region_t *region = (subpicture_region_t *)calloc(1, sizeof(subpicture_region_t));
+    if (region)
+        region->fmt = *fmt;
+    return region;
+}
+
+void subpicture_Delete(subpicture_t *spu)
+{
+    while (spu->p_region) {
+        subpicture_region_t *region = spu->p_region;
+        spu->p_region = region->p_next;
+        while (region->p_text) {
+            text_segment_t *seg = region->p_text;
+            region->p_text = seg->p_next;
+            free(seg->psz_text);
+            free(seg);
+        }
+        free(region);
+    }
+    free(spu);
+}
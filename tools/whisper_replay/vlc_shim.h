@@ -0,0 +1,13 @@
+#ifndef WHISPER_REPLAY_VLC_SHIM_H
+#define WHISPER_REPLAY_VLC_SHIM_H
+
+// Control del sustituto de VLC desde el programa de replay
+
+// Sobrescribe una opción ya registrada por el módulo ("whisper-threads", "4").
+// false si no existe o el valor no es del tipo de la opción.
+bool shim_set_option(const char *name, const char *value);
+
+// 0: solo errores, 1: + info y avisos, 2: + depuración. Todo va a stderr.
+void shim_set_verbosity(int level);
+
+#endif